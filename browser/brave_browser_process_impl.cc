@@ -26,6 +26,7 @@
 #include "brave/components/brave_shields/browser/ad_block_regional_service_manager.h"
 #include "brave/components/brave_shields/browser/ad_block_service.h"
 #include "brave/components/brave_shields/browser/https_everywhere_service.h"
+#include "brave/components/brave_shields/browser/query_trackers_service.h"
 #include "brave/components/brave_shields/browser/tracking_protection_service.h"
 #include "brave/components/brave_sync/buildflags/buildflags.h"
 #include "brave/components/brave_sync/network_time_helper.h"
@@ -196,6 +197,7 @@ void BraveBrowserProcessImpl::StartBraveServices() {
   extension_whitelist_service();
 #endif
   tracking_protection_service();
+  query_trackers_service();
 #if BUILDFLAG(ENABLE_GREASELION)
   greaselion_download_service();
 #endif
@@ -281,6 +283,15 @@ BraveBrowserProcessImpl::tracking_protection_service() {
   return tracking_protection_service_.get();
 }
 
+brave_shields::QueryTrackersService*
+BraveBrowserProcessImpl::query_trackers_service() {
+  if (!query_trackers_service_) {
+    query_trackers_service_ =
+        brave_shields::QueryTrackersServiceFactory(local_data_files_service());
+  }
+  return query_trackers_service_.get();
+}
+
 brave_shields::HTTPSEverywhereService*
 BraveBrowserProcessImpl::https_everywhere_service() {
   if (!https_everywhere_service_)
@@ -41,6 +41,7 @@ class AdBlockService;
 class AdBlockCustomFiltersService;
 class AdBlockRegionalServiceManager;
 class HTTPSEverywhereService;
+class QueryTrackersService;
 class TrackingProtectionService;
 }  // namespace brave_shields
 
@@ -97,6 +98,7 @@ class BraveBrowserProcessImpl : public BrowserProcessImpl {
   greaselion::GreaselionDownloadService* greaselion_download_service();
 #endif
   brave_shields::TrackingProtectionService* tracking_protection_service();
+  brave_shields::QueryTrackersService* query_trackers_service();
   brave_shields::HTTPSEverywhereService* https_everywhere_service();
   brave_component_updater::LocalDataFilesService* local_data_files_service();
 #if BUILDFLAG(ENABLE_TOR)
@@ -153,6 +155,7 @@ class BraveBrowserProcessImpl : public BrowserProcessImpl {
 #endif
   std::unique_ptr<brave_shields::TrackingProtectionService>
       tracking_protection_service_;
+  std::unique_ptr<brave_shields::QueryTrackersService> query_trackers_service_;
   std::unique_ptr<brave_shields::HTTPSEverywhereService>
       https_everywhere_service_;
   std::unique_ptr<brave_stats::BraveStatsUpdater> brave_stats_updater_;
@@ -6,8 +6,12 @@
 #include "base/base64.h"
 #include "base/path_service.h"
 #include "base/task/post_task.h"
+#include "base/test/metrics/histogram_tester.h"
+#include "base/test/scoped_feature_list.h"
+#include "base/test/simple_test_tick_clock.h"
 #include "base/test/thread_test_helper.h"
 #include "brave/browser/brave_browser_process_impl.h"
+#include "brave/browser/net/adblock_cname_cache.h"
 #include "brave/common/brave_paths.h"
 #include "brave/common/pref_names.h"
 #include "brave/components/brave_component_updater/browser/local_data_files_service.h"
@@ -33,6 +37,7 @@
 #include "extensions/test/extension_test_message_listener.h"
 #include "net/dns/mock_host_resolver.h"
 
+using brave_shields::features::kBraveAdblockCnameCache;
 using brave_shields::features::kBraveAdblockCosmeticFiltering;
 using content::BrowserThread;
 using extensions::ExtensionBrowserTest;
@@ -245,6 +250,12 @@ class AdBlockServiceTest : public ExtensionBrowserTest {
     scoped_refptr<base::ThreadTestHelper> tr_helper(new base::ThreadTestHelper(
         g_brave_browser_process->local_data_files_service()->GetTaskRunner()));
     ASSERT_TRUE(tr_helper->Run());
+    // Tag and resource changes rebuild the engine in a follow-up task.
+    scoped_refptr<base::ThreadTestHelper> rebuild_helper(
+        new base::ThreadTestHelper(
+            g_brave_browser_process->local_data_files_service()
+                ->GetTaskRunner()));
+    ASSERT_TRUE(rebuild_helper->Run());
     scoped_refptr<base::ThreadTestHelper> io_helper(new base::ThreadTestHelper(
         base::CreateSingleThreadTaskRunner({BrowserThread::IO}).get()));
     ASSERT_TRUE(io_helper->Run());
@@ -815,6 +826,85 @@ IN_PROC_BROWSER_TEST_F(AdBlockServiceTest, RedirectRulesAreRespected) {
   EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 1ULL);
 }
 
+class AdBlockCnameCacheTest : public AdBlockServiceTest {
+ public:
+  AdBlockCnameCacheTest() {
+    feature_list_.InitAndEnableFeature(kBraveAdblockCnameCache);
+  }
+
+  void SetUpOnMainThread() override {
+    // Rules are matched in order, so the cloaked host needs to come first.
+    host_resolver()->AddIPLiteralRule("cloaked.a.com", "127.0.0.1",
+                                      "tracker.example");
+    AdBlockServiceTest::SetUpOnMainThread();
+    brave::AdblockCnameCache::GetForBrowserContext(browser()->profile())
+        ->SetTickClockForTesting(&clock_);
+  }
+
+  // Loads an image from the cloaked host and expects it to be blocked.
+  void LoadCloakedImage() {
+    GURL tab_url = embedded_test_server()->GetURL("b.com", kAdBlockTestPage);
+    GURL resource_url =
+        embedded_test_server()->GetURL("cloaked.a.com", "/logo.png");
+    ui_test_utils::NavigateToURL(browser(), tab_url);
+    content::WebContents* contents =
+        browser()->tab_strip_model()->GetActiveWebContents();
+    bool as_expected = false;
+    ASSERT_TRUE(ExecuteScriptAndExtractBool(
+        contents,
+        base::StringPrintf("setExpectations(0, 1, 0, 0, 0, 0);"
+                           "addImage('%s')",
+                           resource_url.spec().c_str()),
+        &as_expected));
+    EXPECT_TRUE(as_expected);
+  }
+
+ protected:
+  base::SimpleTestTickClock clock_;
+
+ private:
+  base::test::ScopedFeatureList feature_list_;
+};
+
+// An unknown host is resolved, a known one is matched against the cached
+// canonical name without DNS until the entry expires. Every host of the page
+// goes through the cache, so only the changes between loads are compared.
+IN_PROC_BROWSER_TEST_F(AdBlockCnameCacheTest, CachedCanonicalNameSkipsDns) {
+  UpdateAdBlockInstanceWithRules("||tracker.example^");
+  base::HistogramTester histogram_tester;
+  auto resolutions = [&histogram_tester]() {
+    return histogram_tester
+        .GetHistogramSamplesSinceCreation(
+            "Brave.ShieldsCNAMEBlocking.TotalResolutionTime")
+        ->TotalCount();
+  };
+
+  LoadCloakedImage();
+  const int misses = histogram_tester.GetBucketCount(
+      "Brave.ShieldsCNAMEBlocking.CacheHit", false);
+  const int resolved = resolutions();
+  EXPECT_GT(misses, 0);
+  EXPECT_GT(resolved, 0);
+
+  LoadCloakedImage();
+  EXPECT_GT(histogram_tester.GetBucketCount(
+                "Brave.ShieldsCNAMEBlocking.CacheHit", true),
+            0);
+  EXPECT_EQ(histogram_tester.GetBucketCount(
+                "Brave.ShieldsCNAMEBlocking.CacheHit", false),
+            misses);
+  EXPECT_EQ(resolutions(), resolved);
+
+  clock_.Advance(brave::AdblockCnameCache::kPositiveTTL);
+  LoadCloakedImage();
+  EXPECT_GT(histogram_tester.GetBucketCount(
+                "Brave.ShieldsCNAMEBlocking.CacheHit", false),
+            misses);
+  EXPECT_GT(resolutions(), resolved);
+
+  EXPECT_EQ(browser()->profile()->GetPrefs()->GetUint64(kAdsBlocked), 3ULL);
+}
+
 class CosmeticFilteringFlagDisabledTest : public AdBlockServiceTest {
  public:
   CosmeticFilteringFlagDisabledTest() {
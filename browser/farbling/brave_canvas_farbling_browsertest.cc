@@ -0,0 +1,150 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "base/logging.h"
+#include "base/path_service.h"
+#include "brave/browser/brave_content_browser_client.h"
+#include "brave/common/brave_paths.h"
+#include "brave/components/brave_shields/browser/brave_shields_util.h"
+#include "chrome/browser/content_settings/host_content_settings_map_factory.h"
+#include "chrome/browser/ui/browser.h"
+#include "chrome/common/chrome_content_client.h"
+#include "chrome/test/base/in_process_browser_test.h"
+#include "chrome/test/base/ui_test_utils.h"
+#include "content/public/test/browser_test.h"
+#include "content/public/test/browser_test_utils.h"
+#include "net/dns/mock_host_resolver.h"
+
+using brave_shields::ControlType;
+
+const char kEmbeddedTestServerDirectory[] = "canvas";
+const char kTitleScript[] = "domAutomationController.send(document.title);";
+
+class BraveCanvasFarblingBrowserTest : public InProcessBrowserTest {
+ public:
+  void SetUpOnMainThread() override {
+    InProcessBrowserTest::SetUpOnMainThread();
+
+    content_client_.reset(new ChromeContentClient);
+    content::SetContentClient(content_client_.get());
+    browser_content_client_.reset(new BraveContentBrowserClient());
+    content::SetBrowserClientForTesting(browser_content_client_.get());
+
+    host_resolver()->AddRule("*", "127.0.0.1");
+    content::SetupCrossSiteRedirector(embedded_test_server());
+
+    brave::RegisterPathProvider();
+    base::FilePath test_data_dir;
+    base::PathService::Get(brave::DIR_TEST_DATA, &test_data_dir);
+    test_data_dir = test_data_dir.AppendASCII(kEmbeddedTestServerDirectory);
+    embedded_test_server()->ServeFilesFromDirectory(test_data_dir);
+
+    ASSERT_TRUE(embedded_test_server()->Start());
+
+    top_level_page_url_ = embedded_test_server()->GetURL("a.com", "/");
+    region_url_ = embedded_test_server()->GetURL(
+        "a.com", "/getimagedata-region-farbling.html");
+    read_benchmark_url_ =
+        embedded_test_server()->GetURL("a.com", "/read-benchmark.html");
+  }
+
+  void TearDown() override {
+    browser_content_client_.reset();
+    content_client_.reset();
+  }
+
+  const GURL& region_url() { return region_url_; }
+
+  const GURL& read_benchmark_url() { return read_benchmark_url_; }
+
+  HostContentSettingsMap* content_settings() {
+    return HostContentSettingsMapFactory::GetForProfile(browser()->profile());
+  }
+
+  void AllowFingerprinting() {
+    brave_shields::SetFingerprintingControlType(
+        content_settings(), ControlType::ALLOW, top_level_page_url_);
+  }
+
+  void BlockFingerprinting() {
+    brave_shields::SetFingerprintingControlType(
+        content_settings(), ControlType::BLOCK, top_level_page_url_);
+  }
+
+  void SetFingerprintingDefault() {
+    brave_shields::SetFingerprintingControlType(
+        content_settings(), ControlType::DEFAULT, top_level_page_url_);
+  }
+
+  template <typename T>
+  std::string ExecScriptGetStr(const std::string& script, T* frame) {
+    std::string value;
+    EXPECT_TRUE(ExecuteScriptAndExtractString(frame, script, &value));
+    return value;
+  }
+
+  content::WebContents* contents() {
+    return browser()->tab_strip_model()->GetActiveWebContents();
+  }
+
+  bool NavigateToURLUntilLoadStop(const GURL& url) {
+    ui_test_utils::NavigateToURL(browser(), url);
+    return WaitForLoadStop(contents());
+  }
+
+ private:
+  GURL top_level_page_url_;
+  GURL region_url_;
+  GURL read_benchmark_url_;
+  std::unique_ptr<ChromeContentClient> content_client_;
+  std::unique_ptr<BraveContentBrowserClient> browser_content_client_;
+};
+
+// Tests that getImageData() of part of a canvas is farbled the same as that
+// part of the whole canvas
+IN_PROC_BROWSER_TEST_F(BraveCanvasFarblingBrowserTest,
+                       FarbleGetImageDataRegion) {
+  // Farbling level: maximum
+  BlockFingerprinting();
+  NavigateToURLUntilLoadStop(region_url());
+  EXPECT_EQ(ExecScriptGetStr(kTitleScript, contents()), "pass");
+
+  // Farbling level: balanced (default)
+  SetFingerprintingDefault();
+  NavigateToURLUntilLoadStop(region_url());
+  EXPECT_EQ(ExecScriptGetStr(kTitleScript, contents()), "pass");
+
+  // Farbling level: off
+  AllowFingerprinting();
+  NavigateToURLUntilLoadStop(region_url());
+  EXPECT_EQ(ExecScriptGetStr(kTitleScript, contents()), "pass");
+}
+
+// Times 20 repeated reads of an unchanged 2048x2048 canvas through
+// getImageData() of the whole canvas, getImageData() of a 64x64 region and
+// toDataURL() at each farbling level
+//
+// Disabled by default, as it is a benchmark. Run it with
+// --gtest_also_run_disabled_tests.
+IN_PROC_BROWSER_TEST_F(BraveCanvasFarblingBrowserTest,
+                       DISABLED_LargeCanvasRepeatedReadBenchmark) {
+  BlockFingerprinting();
+  NavigateToURLUntilLoadStop(read_benchmark_url());
+  const std::string maximum_ms = ExecScriptGetStr(kTitleScript, contents());
+
+  SetFingerprintingDefault();
+  NavigateToURLUntilLoadStop(read_benchmark_url());
+  const std::string balanced_ms = ExecScriptGetStr(kTitleScript, contents());
+
+  AllowFingerprinting();
+  NavigateToURLUntilLoadStop(read_benchmark_url());
+  const std::string off_ms = ExecScriptGetStr(kTitleScript, contents());
+
+  LOG(INFO) << "Repeatedly reading a large canvas (full getImageData, region "
+            << "getImageData and toDataURL) took " << maximum_ms
+            << "ms at the maximum farbling level, " << balanced_ms
+            << "ms at the balanced level and " << off_ms << "ms with "
+            << "farbling off";
+}
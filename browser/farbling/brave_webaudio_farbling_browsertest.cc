@@ -3,6 +3,7 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this file,
  * You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include "base/logging.h"
 #include "base/path_service.h"
 #include "base/strings/stringprintf.h"
 #include "base/task/post_task.h"
@@ -57,6 +58,8 @@ class BraveWebAudioFarblingBrowserTest : public InProcessBrowserTest {
     farbling_url_ = embedded_test_server()->GetURL("a.com", "/farbling.html");
     copy_from_channel_url_ =
         embedded_test_server()->GetURL("a.com", "/copyFromChannel.html");
+    read_benchmark_url_ =
+        embedded_test_server()->GetURL("a.com", "/readBenchmark.html");
   }
 
   void TearDown() override {
@@ -68,6 +71,8 @@ class BraveWebAudioFarblingBrowserTest : public InProcessBrowserTest {
 
   const GURL& farbling_url() { return farbling_url_; }
 
+  const GURL& read_benchmark_url() { return read_benchmark_url_; }
+
   HostContentSettingsMap* content_settings() {
     return HostContentSettingsMapFactory::GetForProfile(browser()->profile());
   }
@@ -107,6 +112,7 @@ class BraveWebAudioFarblingBrowserTest : public InProcessBrowserTest {
   GURL top_level_page_url_;
   GURL copy_from_channel_url_;
   GURL farbling_url_;
+  GURL read_benchmark_url_;
   std::unique_ptr<ChromeContentClient> content_client_;
   std::unique_ptr<BraveContentBrowserClient> browser_content_client_;
 };
@@ -143,3 +149,28 @@ IN_PROC_BROWSER_TEST_F(BraveWebAudioFarblingBrowserTest, FarbleWebAudio) {
   NavigateToURLUntilLoadStop(farbling_url());
   EXPECT_EQ(ExecScriptGetStr(kTitleScript, contents()), "8000");
 }
+
+// Times 20 reads of a minute of 48kHz audio through getChannelData and
+// copyFromChannel at each farbling level
+//
+// Disabled by default, as it is a benchmark. Run it with
+// --gtest_also_run_disabled_tests.
+IN_PROC_BROWSER_TEST_F(BraveWebAudioFarblingBrowserTest,
+                       DISABLED_LargeAudioBufferReadBenchmark) {
+  BlockFingerprinting();
+  NavigateToURLUntilLoadStop(read_benchmark_url());
+  const std::string maximum_ms = ExecScriptGetStr(kTitleScript, contents());
+
+  SetFingerprintingDefault();
+  NavigateToURLUntilLoadStop(read_benchmark_url());
+  const std::string balanced_ms = ExecScriptGetStr(kTitleScript, contents());
+
+  AllowFingerprinting();
+  NavigateToURLUntilLoadStop(read_benchmark_url());
+  const std::string off_ms = ExecScriptGetStr(kTitleScript, contents());
+
+  LOG(INFO) << "Reading large audio buffers took " << maximum_ms
+            << "ms at the maximum farbling level, " << balanced_ms
+            << "ms at the balanced level and " << off_ms << "ms with "
+            << "farbling off";
+}
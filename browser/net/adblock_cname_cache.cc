@@ -0,0 +1,80 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/browser/net/adblock_cname_cache.h"
+
+#include <memory>
+
+#include "base/time/default_tick_clock.h"
+#include "base/time/tick_clock.h"
+#include "content/public/browser/browser_context.h"
+#include "content/public/browser/browser_thread.h"
+
+namespace brave {
+
+namespace {
+
+const char kAdblockCnameCacheKey[] = "brave_adblock_cname_cache";
+
+}  // namespace
+
+constexpr base::TimeDelta AdblockCnameCache::kPositiveTTL;
+constexpr base::TimeDelta AdblockCnameCache::kNegativeTTL;
+
+AdblockCnameCache::AdblockCnameCache(const base::TickClock* tick_clock)
+    : tick_clock_(tick_clock), entries_(kMaxEntries) {}
+
+AdblockCnameCache::~AdblockCnameCache() = default;
+
+// static
+AdblockCnameCache* AdblockCnameCache::GetForBrowserContext(
+    content::BrowserContext* context) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  AdblockCnameCache* cache = static_cast<AdblockCnameCache*>(
+      context->GetUserData(kAdblockCnameCacheKey));
+  if (!cache) {
+    // Object cleanup is handled by SupportsUserData
+    context->SetUserData(kAdblockCnameCacheKey,
+                         std::make_unique<AdblockCnameCache>(
+                             base::DefaultTickClock::GetInstance()));
+    cache = static_cast<AdblockCnameCache*>(
+        context->GetUserData(kAdblockCnameCacheKey));
+  }
+  return cache;
+}
+
+bool AdblockCnameCache::Get(const std::string& host,
+                            base::Optional<std::string>* canonical_name) {
+  auto it = entries_.Get(host);
+  if (it == entries_.end())
+    return false;
+  if (it->second.expiration <= tick_clock_->NowTicks()) {
+    entries_.Erase(it);
+    return false;
+  }
+  *canonical_name = it->second.canonical_name;
+  return true;
+}
+
+void AdblockCnameCache::Put(
+    const std::string& host,
+    const base::Optional<std::string>& canonical_name) {
+  Entry entry;
+  entry.canonical_name = canonical_name;
+  entry.expiration = tick_clock_->NowTicks() +
+                     (canonical_name ? kPositiveTTL : kNegativeTTL);
+  entries_.Put(host, entry);
+}
+
+base::WeakPtr<AdblockCnameCache> AdblockCnameCache::AsWeakPtr() {
+  return weak_factory_.GetWeakPtr();
+}
+
+void AdblockCnameCache::SetTickClockForTesting(
+    const base::TickClock* tick_clock) {
+  tick_clock_ = tick_clock;
+}
+
+}  // namespace brave
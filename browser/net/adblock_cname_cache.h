@@ -0,0 +1,75 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_BROWSER_NET_ADBLOCK_CNAME_CACHE_H_
+#define BRAVE_BROWSER_NET_ADBLOCK_CNAME_CACHE_H_
+
+#include <string>
+
+#include "base/containers/mru_cache.h"
+#include "base/macros.h"
+#include "base/memory/weak_ptr.h"
+#include "base/optional.h"
+#include "base/supports_user_data.h"
+#include "base/time/time.h"
+
+namespace base {
+class TickClock;
+}  // namespace base
+
+namespace content {
+class BrowserContext;
+}  // namespace content
+
+namespace brave {
+
+// Per-profile cache of host -> canonical name resolutions used for CNAME
+// uncloaking, so repeat hosts don't put a DNS round trip on the ad-block
+// path. Failed resolutions are cached too, for a shorter time. Lives on the
+// UI thread.
+class AdblockCnameCache : public base::SupportsUserData::Data {
+ public:
+  // The mojo ResolveHost API doesn't report record TTLs, so positive entries
+  // use the same default as net::HostCache for system resolutions.
+  static constexpr base::TimeDelta kPositiveTTL =
+      base::TimeDelta::FromMinutes(1);
+  static constexpr base::TimeDelta kNegativeTTL =
+      base::TimeDelta::FromSeconds(10);
+  static constexpr size_t kMaxEntries = 1000;
+
+  explicit AdblockCnameCache(const base::TickClock* tick_clock);
+  ~AdblockCnameCache() override;
+
+  static AdblockCnameCache* GetForBrowserContext(
+      content::BrowserContext* context);
+
+  // Returns true if |host| has a fresh entry. |canonical_name| is set to the
+  // cached canonical name, or base::nullopt when resolution had failed.
+  bool Get(const std::string& host,
+           base::Optional<std::string>* canonical_name);
+  void Put(const std::string& host,
+           const base::Optional<std::string>& canonical_name);
+
+  base::WeakPtr<AdblockCnameCache> AsWeakPtr();
+
+  void SetTickClockForTesting(const base::TickClock* tick_clock);
+
+ private:
+  struct Entry {
+    base::Optional<std::string> canonical_name;
+    base::TimeTicks expiration;
+  };
+
+  const base::TickClock* tick_clock_;
+  base::MRUCache<std::string, Entry> entries_;
+
+  base::WeakPtrFactory<AdblockCnameCache> weak_factory_{this};
+
+  DISALLOW_COPY_AND_ASSIGN(AdblockCnameCache);
+};
+
+}  // namespace brave
+
+#endif  // BRAVE_BROWSER_NET_ADBLOCK_CNAME_CACHE_H_
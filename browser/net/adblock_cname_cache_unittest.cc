@@ -0,0 +1,43 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/browser/net/adblock_cname_cache.h"
+
+#include <string>
+
+#include "base/test/simple_test_tick_clock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace brave {
+
+TEST(AdblockCnameCacheTest, PositiveEntriesExpire) {
+  base::SimpleTestTickClock clock;
+  AdblockCnameCache cache(&clock);
+
+  base::Optional<std::string> canonical_name;
+  EXPECT_FALSE(cache.Get("metrics.brave.com", &canonical_name));
+
+  cache.Put("metrics.brave.com", std::string("tracker.example"));
+  ASSERT_TRUE(cache.Get("metrics.brave.com", &canonical_name));
+  EXPECT_EQ("tracker.example", *canonical_name);
+
+  clock.Advance(AdblockCnameCache::kPositiveTTL);
+  EXPECT_FALSE(cache.Get("metrics.brave.com", &canonical_name));
+}
+
+TEST(AdblockCnameCacheTest, NegativeEntriesExpireSooner) {
+  base::SimpleTestTickClock clock;
+  AdblockCnameCache cache(&clock);
+
+  cache.Put("unresolvable.example", base::nullopt);
+  base::Optional<std::string> canonical_name("stale");
+  ASSERT_TRUE(cache.Get("unresolvable.example", &canonical_name));
+  EXPECT_FALSE(canonical_name.has_value());
+
+  clock.Advance(AdblockCnameCache::kNegativeTTL);
+  EXPECT_FALSE(cache.Get("unresolvable.example", &canonical_name));
+}
+
+}  // namespace brave
@@ -11,14 +11,19 @@
 #include <vector>
 
 #include "base/base64url.h"
+#include "base/feature_list.h"
+#include "base/metrics/histogram_macros.h"
 #include "base/strings/string_util.h"
+#include "base/task/post_task.h"
 #include "brave/browser/brave_browser_process_impl.h"
+#include "brave/browser/net/adblock_cname_cache.h"
 #include "brave/browser/net/url_context.h"
 #include "brave/common/network_constants.h"
 #include "brave/components/brave_shields/browser/ad_block_service.h"
 #include "brave/components/brave_shields/browser/brave_shields_util.h"
 #include "brave/components/brave_shields/browser/brave_shields_web_contents_observer.h"
 #include "brave/components/brave_shields/common/brave_shield_constants.h"
+#include "brave/components/brave_shields/common/features.h"
 #include "brave/grit/brave_generated_resources.h"
 #include "content/public/browser/browser_context.h"
 #include "content/public/browser/browser_thread.h"
@@ -54,34 +59,56 @@ content::WebContents* GetWebContents(int render_process_id,
 
 }  // namespace
 
-void ShouldBlockAdOnTaskRunner(std::shared_ptr<BraveRequestInfo> ctx,
-                               base::Optional<std::string> canonical_name) {
+// Matches the request URL itself, without any CNAME uncloaking. Returns
+// whether an exception rule matched.
+bool ShouldBlockAdWithoutCnameOnTaskRunner(
+    std::shared_ptr<BraveRequestInfo> ctx) {
   bool did_match_exception = false;
-  std::string tab_host = ctx->tab_origin.host();
   if (!g_brave_browser_process->ad_block_service()->ShouldStartRequest(
-          ctx->request_url, ctx->resource_type, tab_host, &did_match_exception,
-          &ctx->cancel_request_explicitly, &ctx->mock_data_url)) {
+          ctx->request_url, ctx->resource_type, ctx->tab_origin.host(),
+          &did_match_exception, &ctx->cancel_request_explicitly,
+          &ctx->mock_data_url)) {
     ctx->blocked_by = kAdBlocked;
-  } else if (!did_match_exception && canonical_name.has_value() &&
-             ctx->request_url.host() != *canonical_name &&
-             *canonical_name != "") {
-    GURL::Replacements replacements = GURL::Replacements();
-    replacements.SetHost(
-        canonical_name->c_str(),
-        url::Component(0, static_cast<int>(canonical_name->length())));
-    const GURL canonical_url = ctx->request_url.ReplaceComponents(replacements);
-
-    if (!g_brave_browser_process->ad_block_service()->ShouldStartRequest(
-            canonical_url, ctx->resource_type, tab_host, &did_match_exception,
-            &ctx->cancel_request_explicitly, &ctx->mock_data_url)) {
-      ctx->blocked_by = kAdBlocked;
-    }
   }
+  return did_match_exception;
+}
+
+// Matches the request URL with its host replaced by |canonical_name|, for
+// requests the URL itself didn't decide.
+void ShouldBlockCanonicalNameOnTaskRunner(
+    std::shared_ptr<BraveRequestInfo> ctx,
+    base::Optional<std::string> canonical_name) {
+  if (!canonical_name.has_value() ||
+      ctx->request_url.host() == *canonical_name || *canonical_name == "") {
+    return;
+  }
+
+  GURL::Replacements replacements = GURL::Replacements();
+  replacements.SetHost(
+      canonical_name->c_str(),
+      url::Component(0, static_cast<int>(canonical_name->length())));
+  const GURL canonical_url = ctx->request_url.ReplaceComponents(replacements);
+
+  bool did_match_exception = false;
+  if (!g_brave_browser_process->ad_block_service()->ShouldStartRequest(
+          canonical_url, ctx->resource_type, ctx->tab_origin.host(),
+          &did_match_exception, &ctx->cancel_request_explicitly,
+          &ctx->mock_data_url)) {
+    ctx->blocked_by = kAdBlocked;
+  }
+}
+
+void ShouldBlockAdOnTaskRunner(std::shared_ptr<BraveRequestInfo> ctx,
+                               base::Optional<std::string> canonical_name) {
+  if (ShouldBlockAdWithoutCnameOnTaskRunner(ctx) ||
+      ctx->blocked_by == kAdBlocked) {
+    return;
+  }
+  ShouldBlockCanonicalNameOnTaskRunner(ctx, canonical_name);
 }
 
 void OnShouldBlockAdResult(const ResponseCallback& next_callback,
                            std::shared_ptr<BraveRequestInfo> ctx) {
-  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
   if (ctx->blocked_by == kAdBlocked) {
     brave_shields::DispatchBlockedEvent(
         ctx->request_url, ctx->render_frame_id, ctx->render_process_id,
@@ -90,30 +117,57 @@ void OnShouldBlockAdResult(const ResponseCallback& next_callback,
   next_callback.Run();
 }
 
+// |request_url_matched| tells whether the request URL itself was already
+// matched, in which case only the canonical name is left to match.
 void ShouldBlockAdWithOptionalCname(
-    scoped_refptr<base::SequencedTaskRunner> task_runner,
+    scoped_refptr<base::TaskRunner> task_runner,
     const ResponseCallback& next_callback,
     std::shared_ptr<BraveRequestInfo> ctx,
+    bool request_url_matched,
     const base::Optional<std::string> cname) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
   task_runner->PostTaskAndReply(
-      FROM_HERE, base::BindOnce(&ShouldBlockAdOnTaskRunner, ctx, cname),
+      FROM_HERE,
+      base::BindOnce(request_url_matched ? &ShouldBlockCanonicalNameOnTaskRunner
+                                         : &ShouldBlockAdOnTaskRunner,
+                     ctx, cname),
       base::BindOnce(&OnShouldBlockAdResult, next_callback, ctx));
 }
 
+// Returns true if the canonical name of the request host is cached, in which
+// case no DNS round trip is needed, whether or not it turned out to be
+// cloaked.
+bool GetCachedCanonicalName(std::shared_ptr<BraveRequestInfo> ctx,
+                            base::Optional<std::string>* canonical_name) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  auto* web_contents = GetWebContents(
+      ctx->render_process_id, ctx->render_frame_id, ctx->frame_tree_node_id);
+  bool cache_hit =
+      web_contents &&
+      AdblockCnameCache::GetForBrowserContext(
+          web_contents->GetBrowserContext())
+          ->Get(ctx->request_url.host(), canonical_name);
+  UMA_HISTOGRAM_BOOLEAN("Brave.ShieldsCNAMEBlocking.CacheHit", cache_hit);
+  return cache_hit;
+}
+
 class AdblockCnameResolveHostClient : public network::mojom::ResolveHostClient {
  private:
   mojo::Receiver<network::mojom::ResolveHostClient> receiver_{this};
   base::OnceCallback<void(base::Optional<std::string>)> cb_;
   base::TimeTicks start_time_;
+  base::WeakPtr<AdblockCnameCache> cname_cache_;
+  std::string host_;
 
  public:
   AdblockCnameResolveHostClient(
       const ResponseCallback& next_callback,
-      scoped_refptr<base::SequencedTaskRunner> task_runner,
-      std::shared_ptr<BraveRequestInfo> ctx) {
+      scoped_refptr<base::TaskRunner> task_runner,
+      std::shared_ptr<BraveRequestInfo> ctx,
+      bool request_url_matched) {
     cb_ = base::BindOnce(&ShouldBlockAdWithOptionalCname, task_runner,
-                         std::move(next_callback), ctx);
+                         std::move(next_callback), ctx, request_url_matched);
+    host_ = ctx->request_url.host();
 
     auto* web_contents = GetWebContents(
         ctx->render_process_id, ctx->render_frame_id, ctx->frame_tree_node_id);
@@ -124,6 +178,11 @@ class AdblockCnameResolveHostClient : public network::mojom::ResolveHostClient {
     }
 
     content::BrowserContext* context = web_contents->GetBrowserContext();
+    if (base::FeatureList::IsEnabled(
+            brave_shields::features::kBraveAdblockCnameCache)) {
+      cname_cache_ =
+          AdblockCnameCache::GetForBrowserContext(context)->AsWeakPtr();
+    }
 
     const auto network_isolation_key = ctx->network_isolation_key;
 
@@ -153,13 +212,14 @@ class AdblockCnameResolveHostClient : public network::mojom::ResolveHostClient {
       const base::Optional<net::AddressList>& resolved_addresses) override {
     UMA_HISTOGRAM_TIMES("Brave.ShieldsCNAMEBlocking.TotalResolutionTime",
                         base::TimeTicks::Now() - start_time_);
+    base::Optional<std::string> canonical_name;
     if (result == net::OK && resolved_addresses) {
       DCHECK(resolved_addresses.has_value() && !resolved_addresses->empty());
-      std::move(cb_).Run(
-          base::Optional<std::string>(resolved_addresses->canonical_name()));
-    } else {
-      std::move(cb_).Run(base::nullopt);
+      canonical_name = resolved_addresses->canonical_name();
     }
+    if (cname_cache_)
+      cname_cache_->Put(host_, canonical_name);
+    std::move(cb_).Run(canonical_name);
 
     delete this;
   }
@@ -175,9 +235,46 @@ class AdblockCnameResolveHostClient : public network::mojom::ResolveHostClient {
   }
 };
 
+// Resolves the canonical name of the request host, from the cache if it is
+// known, and matches the request against it. The request URL itself has
+// already been matched.
+void ShouldBlockAdWithCname(
+    scoped_refptr<base::TaskRunner> task_runner,
+    const ResponseCallback& next_callback,
+    std::shared_ptr<BraveRequestInfo> ctx) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  base::Optional<std::string> canonical_name;
+  if (base::FeatureList::IsEnabled(
+          brave_shields::features::kBraveAdblockCnameCache) &&
+      GetCachedCanonicalName(ctx, &canonical_name)) {
+    ShouldBlockAdWithOptionalCname(task_runner, next_callback, ctx, true,
+                                   canonical_name);
+    return;
+  }
+  new AdblockCnameResolveHostClient(next_callback, task_runner, ctx, true);
+}
+
+void OnShouldBlockAdWithoutCnameResult(
+    scoped_refptr<base::TaskRunner> task_runner,
+    const ResponseCallback& next_callback,
+    std::shared_ptr<BraveRequestInfo> ctx,
+    bool did_match_exception) {
+  if (ctx->blocked_by == kAdBlocked || did_match_exception) {
+    OnShouldBlockAdResult(next_callback, ctx);
+    return;
+  }
+  if (!content::BrowserThread::CurrentlyOn(content::BrowserThread::UI)) {
+    base::PostTask(FROM_HERE, {content::BrowserThread::UI},
+                   base::BindOnce(&ShouldBlockAdWithCname, task_runner,
+                                  next_callback, ctx));
+    return;
+  }
+  // The cache was already consulted before the request URL was matched.
+  new AdblockCnameResolveHostClient(next_callback, task_runner, ctx, true);
+}
+
 void OnBeforeURLRequestAdBlockTP(const ResponseCallback& next_callback,
                                  std::shared_ptr<BraveRequestInfo> ctx) {
-  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
   // If the following info isn't available, then proper content settings can't
   // be looked up, so do nothing.
   if (ctx->tab_origin.is_empty() || !ctx->tab_origin.has_host() ||
@@ -186,10 +283,33 @@ void OnBeforeURLRequestAdBlockTP(const ResponseCallback& next_callback,
   }
   DCHECK_NE(ctx->request_identifier, 0UL);
 
-  scoped_refptr<base::SequencedTaskRunner> task_runner =
-      g_brave_browser_process->ad_block_service()->GetTaskRunner();
+  scoped_refptr<base::TaskRunner> task_runner =
+      g_brave_browser_process->ad_block_service()->GetMatchingTaskRunner();
+
+  if (content::BrowserThread::CurrentlyOn(content::BrowserThread::UI)) {
+    if (!base::FeatureList::IsEnabled(
+            brave_shields::features::kBraveAdblockCnameCache)) {
+      new AdblockCnameResolveHostClient(std::move(next_callback), task_runner,
+                                        ctx, false);
+      return;
+    }
+
+    base::Optional<std::string> canonical_name;
+    if (GetCachedCanonicalName(ctx, &canonical_name)) {
+      ShouldBlockAdWithOptionalCname(task_runner, next_callback, ctx, false,
+                                     canonical_name);
+      return;
+    }
+  }
 
-  new AdblockCnameResolveHostClient(std::move(next_callback), task_runner, ctx);
+  // Otherwise match the request as-is right away and only wait for DNS when
+  // that doesn't already decide it. Off the UI thread the CNAME cache can't be
+  // looked up, so that's done too only when the request is still undecided.
+  base::PostTaskAndReplyWithResult(
+      task_runner.get(), FROM_HERE,
+      base::BindOnce(&ShouldBlockAdWithoutCnameOnTaskRunner, ctx),
+      base::BindOnce(&OnShouldBlockAdWithoutCnameResult, task_runner,
+                     next_callback, ctx));
 }
 
 int OnBeforeURLRequest_AdBlockTPPreWork(const ResponseCallback& next_callback,
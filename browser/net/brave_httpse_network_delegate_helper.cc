@@ -15,10 +15,6 @@
 #include "brave/components/brave_shields/browser/brave_shields_util.h"
 #include "brave/components/brave_shields/browser/https_everywhere_service.h"
 #include "brave/components/brave_shields/common/brave_shield_constants.h"
-#include "content/public/browser/browser_thread.h"
-
-using content::BrowserThread;
-
 namespace brave {
 
 void OnBeforeURLRequest_HttpseFileWork(
@@ -33,8 +29,6 @@ void OnBeforeURLRequest_HttpseFileWork(
 void OnBeforeURLRequest_HttpsePostFileWork(
     const ResponseCallback& next_callback,
     std::shared_ptr<BraveRequestInfo> ctx) {
-  DCHECK_CURRENTLY_ON(BrowserThread::UI);
-
   if (!ctx->new_url_spec.empty() &&
     ctx->new_url_spec != ctx->request_url.spec()) {
     brave_shields::DispatchBlockedEvent(ctx->request_url,
@@ -48,8 +42,6 @@ void OnBeforeURLRequest_HttpsePostFileWork(
 int OnBeforeURLRequest_HttpsePreFileWork(
     const ResponseCallback& next_callback,
     std::shared_ptr<BraveRequestInfo> ctx) {
-  DCHECK_CURRENTLY_ON(BrowserThread::UI);
-
   // Don't try to overwrite an already set URL by another delegate (adblock/tp)
   if (!ctx->new_url_spec.empty()) {
     return net::OK;
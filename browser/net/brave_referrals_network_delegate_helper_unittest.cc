@@ -7,10 +7,17 @@
 
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "base/json/json_reader.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/timer/elapsed_timer.h"
 #include "brave/browser/net/url_context.h"
 #include "brave/common/network_constants.h"
+#include "brave/components/brave_referrals/browser/brave_referrals_service.h"
+#include "brave/components/brave_referrals/browser/referral_headers_matcher.h"
 #include "net/base/net_errors.h"
 #include "testing/gtest/include/gtest/gtest.h"
 #include "url/gurl.h"
@@ -62,9 +69,11 @@ TEST(BraveReferralsNetworkDelegateHelperTest, ReplaceHeadersForMatchingDomain) {
   const base::ListValue* referral_headers_list = nullptr;
   referral_headers.value->GetAsList(&referral_headers_list);
 
+  const brave::ReferralHeadersMatcher matcher(*referral_headers_list);
+
   net::HttpRequestHeaders headers;
   auto request_info = std::make_shared<brave::BraveRequestInfo>(url);
-  request_info->referral_headers_list = referral_headers_list;
+  request_info->referral_headers_matcher = &matcher;
 
   int rc = brave::OnBeforeStartTransaction_ReferralsWork(
       &headers, brave::ResponseCallback(), request_info);
@@ -91,12 +100,135 @@ TEST(BraveReferralsNetworkDelegateHelperTest,
   const base::ListValue* referral_headers_list = nullptr;
   referral_headers.value->GetAsList(&referral_headers_list);
 
+  const brave::ReferralHeadersMatcher matcher(*referral_headers_list);
+
   net::HttpRequestHeaders headers;
   auto request_info = std::make_shared<brave::BraveRequestInfo>(GURL());
-  request_info->referral_headers_list = referral_headers_list;
+  request_info->referral_headers_matcher = &matcher;
   int rc = brave::OnBeforeStartTransaction_ReferralsWork(
       &headers, brave::ResponseCallback(), request_info);
 
   EXPECT_FALSE(headers.HasHeader("X-Brave-Partner"));
   EXPECT_EQ(rc, net::OK);
 }
+
+TEST(BraveReferralsNetworkDelegateHelperTest, MatchSubdomainsOnly) {
+  base::JSONReader::ValueWithError referral_headers =
+      base::JSONReader::ReadAndReturnValueWithError(kTestReferralHeaders);
+  ASSERT_TRUE(referral_headers.value);
+  const base::ListValue* referral_headers_list = nullptr;
+  ASSERT_TRUE(referral_headers.value->GetAsList(&referral_headers_list));
+
+  const brave::ReferralHeadersMatcher matcher(*referral_headers_list);
+
+  EXPECT_TRUE(matcher.GetMatchingHeaders(GURL("http://xxlmag.com/foo")));
+  EXPECT_TRUE(matcher.GetMatchingHeaders(GURL("https://a.b.xxlmag.com/")));
+  EXPECT_FALSE(matcher.GetMatchingHeaders(GURL("https://notxxlmag.com/")));
+  EXPECT_FALSE(matcher.GetMatchingHeaders(GURL("https://xxlmag.com.evil/")));
+  EXPECT_FALSE(matcher.GetMatchingHeaders(GURL("ftp://xxlmag.com/")));
+}
+
+TEST(BraveReferralsNetworkDelegateHelperTest, MatchAnyDomain) {
+  base::JSONReader::ValueWithError referral_headers =
+      base::JSONReader::ReadAndReturnValueWithError(R"(
+        [
+          {
+            "domains": ["marketwatch.com"],
+            "headers": {"X-Brave-Partner": "dowjones"}
+          },
+          {
+            "domains": ["*"],
+            "headers": {"X-Brave-Partner": "any"}
+          }
+        ])");
+  ASSERT_TRUE(referral_headers.value);
+  const base::ListValue* referral_headers_list = nullptr;
+  ASSERT_TRUE(referral_headers.value->GetAsList(&referral_headers_list));
+
+  const brave::ReferralHeadersMatcher matcher(*referral_headers_list);
+
+  const base::DictionaryValue* headers_dict =
+      matcher.GetMatchingHeaders(GURL("https://www.marketwatch.com/"));
+  ASSERT_TRUE(headers_dict);
+  EXPECT_EQ(*headers_dict->FindStringKey(kBravePartnerHeader), "dowjones");
+
+  headers_dict = matcher.GetMatchingHeaders(GURL("http://example.com/"));
+  ASSERT_TRUE(headers_dict);
+  EXPECT_EQ(*headers_dict->FindStringKey(kBravePartnerHeader), "any");
+
+  EXPECT_FALSE(matcher.GetMatchingHeaders(GURL("ftp://example.com/")));
+
+  const base::DictionaryValue* request_headers_dict = nullptr;
+  ASSERT_TRUE(brave::BraveReferralsService::GetMatchingReferralHeaders(
+      *referral_headers_list, &request_headers_dict,
+      GURL("https://localhost/")));
+  EXPECT_EQ(*request_headers_dict->FindStringKey(kBravePartnerHeader), "any");
+}
+
+// Disabled by default, as it is a benchmark. Run it with
+// --gtest_also_run_disabled_tests.
+TEST(BraveReferralsNetworkDelegateHelperTest,
+     DISABLED_MatchThousandDomainsBenchmark) {
+  const size_t kDomainCount = 1000;
+  const size_t kDomainsPerEntry = 10;
+
+  base::ListValue referral_headers_list;
+  for (size_t i = 0; i < kDomainCount / kDomainsPerEntry; ++i) {
+    base::Value domains(base::Value::Type::LIST);
+    for (size_t j = 0; j < kDomainsPerEntry; ++j) {
+      domains.GetList().emplace_back(
+          "partner" + base::NumberToString(i * kDomainsPerEntry + j) + ".com");
+    }
+    base::Value headers(base::Value::Type::DICTIONARY);
+    headers.SetStringKey(kBravePartnerHeader,
+                         "partner" + base::NumberToString(i));
+    base::Value entry(base::Value::Type::DICTIONARY);
+    entry.SetKey("domains", std::move(domains));
+    entry.SetKey("headers", std::move(headers));
+    referral_headers_list.GetList().push_back(std::move(entry));
+  }
+
+  std::vector<GURL> urls;
+  for (size_t i = 0; i < kDomainCount; ++i) {
+    urls.push_back(GURL("https://www.partner" + base::NumberToString(i) +
+                        ".com/index.html"));
+    urls.push_back(GURL("https://www.example" + base::NumberToString(i) +
+                        ".com/index.html"));
+  }
+
+  // GetMatchingReferralHeaders builds a matcher from the list for every
+  // request, where requests otherwise share one.
+  base::ElapsedTimer list_timer;
+  std::vector<const base::DictionaryValue*> list_headers;
+  for (const auto& url : urls) {
+    const base::DictionaryValue* request_headers_dict = nullptr;
+    brave::BraveReferralsService::GetMatchingReferralHeaders(
+        referral_headers_list, &request_headers_dict, url);
+    list_headers.push_back(request_headers_dict);
+  }
+  const base::TimeDelta list_elapsed = list_timer.Elapsed();
+
+  base::ElapsedTimer build_timer;
+  const brave::ReferralHeadersMatcher matcher(referral_headers_list);
+  const base::TimeDelta build_elapsed = build_timer.Elapsed();
+
+  base::ElapsedTimer matcher_timer;
+  std::vector<const base::DictionaryValue*> matcher_headers;
+  for (const auto& url : urls) {
+    matcher_headers.push_back(matcher.GetMatchingHeaders(url));
+  }
+  const base::TimeDelta matcher_elapsed = matcher_timer.Elapsed();
+
+  ASSERT_EQ(list_headers.size(), matcher_headers.size());
+  for (size_t i = 0; i < list_headers.size(); ++i) {
+    ASSERT_EQ(!!list_headers[i], !!matcher_headers[i]) << urls[i];
+    if (list_headers[i])
+      EXPECT_EQ(*list_headers[i], *matcher_headers[i]) << urls[i];
+  }
+
+  LOG(INFO) << "Matched " << urls.size() << " requests against "
+            << kDomainCount << " domains in "
+            << matcher_elapsed.InMicroseconds() << "us using the matcher "
+            << "built in " << build_elapsed.InMicroseconds() << "us ("
+            << list_elapsed.InMicroseconds() << "us building it per request)";
+}
@@ -8,7 +8,9 @@
 #include <algorithm>
 #include <utility>
 
+#include "base/feature_list.h"
 #include "base/metrics/histogram_macros.h"
+#include "base/sequenced_task_runner.h"
 #include "base/task/post_task.h"
 #include "brave/browser/net/brave_ad_block_tp_network_delegate_helper.h"
 #include "brave/browser/net/brave_common_static_redirect_network_delegate_helper.h"
@@ -20,6 +22,7 @@
 #include "brave/common/pref_names.h"
 #include "brave/components/brave_referrals/buildflags/buildflags.h"
 #include "brave/components/brave_rewards/browser/buildflags/buildflags.h"
+#include "brave/components/brave_shields/common/features.h"
 #include "brave/components/brave_webtorrent/browser/buildflags/buildflags.h"
 #include "brave/components/ipfs/buildflags/buildflags.h"
 #include "chrome/browser/browser_process.h"
@@ -33,6 +36,7 @@
 
 #if BUILDFLAG(ENABLE_BRAVE_REFERRALS)
 #include "brave/browser/net/brave_referrals_network_delegate_helper.h"
+#include "brave/components/brave_referrals/browser/referral_headers_matcher.h"
 #endif
 
 #if BUILDFLAG(BRAVE_REWARDS_ENABLED)
@@ -57,9 +61,123 @@ static bool IsInternalScheme(std::shared_ptr<brave::BraveRequestInfo> ctx) {
          ctx->request_url.SchemeIs(content::kChromeUIScheme);
 }
 
-BraveRequestHandler::BraveRequestHandler() {
+BraveRequestHandler::CallbackChain::CallbackChain() = default;
+
+BraveRequestHandler::CallbackChain::~CallbackChain() = default;
+
+void BraveRequestHandler::CallbackChain::AddBeforeURLRequestCallback(
+    const brave::OnBeforeURLRequestCallback& callback,
+    CallbackThread thread) {
+  before_url_request_callbacks.push_back(callback);
+  before_url_request_threads_.push_back(thread);
+}
+
+void BraveRequestHandler::CallbackChain::AddBeforeStartTransactionCallback(
+    const brave::OnBeforeStartTransactionCallback& callback,
+    CallbackThread thread) {
+  before_start_transaction_callbacks.push_back(callback);
+  before_start_transaction_threads_.push_back(thread);
+}
+
+void BraveRequestHandler::CallbackChain::AddHeadersReceivedCallback(
+    const brave::OnHeadersReceivedCallback& callback,
+    CallbackThread thread) {
+  headers_received_callbacks.push_back(callback);
+  headers_received_threads_.push_back(thread);
+}
+
+BraveRequestHandler::CallbackThread
+BraveRequestHandler::CallbackChain::GetNextCallbackThread(
+    std::shared_ptr<brave::BraveRequestInfo> ctx) const {
+  if (ctx->event_type == brave::kOnBeforeRequest) {
+    return before_url_request_threads_[ctx->next_url_request_index];
+  }
+  if (ctx->event_type == brave::kOnBeforeStartTransaction) {
+    return before_start_transaction_threads_[ctx->next_url_request_index];
+  }
+  DCHECK_EQ(ctx->event_type, brave::kOnHeadersReceived);
+  return headers_received_threads_[ctx->next_url_request_index];
+}
+
+// TODO(iefremov): Merge all callback containers into one and run only one loop
+// instead of many (issues/5574).
+int BraveRequestHandler::CallbackChain::Run(
+    const brave::ResponseCallback& next_callback,
+    std::shared_ptr<brave::BraveRequestInfo> ctx,
+    base::Optional<CallbackThread> thread,
+    bool* switch_thread) const {
+  *switch_thread = false;
+
+  // Continue processing callbacks until we hit one that returns PENDING
+  int rv = net::OK;
+
+  if (ctx->event_type == brave::kOnBeforeRequest) {
+    while (before_url_request_callbacks.size() !=
+           ctx->next_url_request_index) {
+      if (thread && GetNextCallbackThread(ctx) != *thread) {
+        *switch_thread = true;
+        return net::ERR_IO_PENDING;
+      }
+      brave::OnBeforeURLRequestCallback callback =
+          before_url_request_callbacks[ctx->next_url_request_index++];
+      rv = callback.Run(next_callback, ctx);
+      if (rv == net::ERR_IO_PENDING) {
+        return rv;
+      }
+      if (rv != net::OK) {
+        break;
+      }
+    }
+  } else if (ctx->event_type == brave::kOnBeforeStartTransaction) {
+    while (before_start_transaction_callbacks.size() !=
+           ctx->next_url_request_index) {
+      if (thread && GetNextCallbackThread(ctx) != *thread) {
+        *switch_thread = true;
+        return net::ERR_IO_PENDING;
+      }
+      brave::OnBeforeStartTransactionCallback callback =
+          before_start_transaction_callbacks[ctx->next_url_request_index++];
+      rv = callback.Run(ctx->headers, next_callback, ctx);
+      if (rv == net::ERR_IO_PENDING) {
+        return rv;
+      }
+      if (rv != net::OK) {
+        break;
+      }
+    }
+  } else if (ctx->event_type == brave::kOnHeadersReceived) {
+    while (headers_received_callbacks.size() != ctx->next_url_request_index) {
+      if (thread && GetNextCallbackThread(ctx) != *thread) {
+        *switch_thread = true;
+        return net::ERR_IO_PENDING;
+      }
+      brave::OnHeadersReceivedCallback callback =
+          headers_received_callbacks[ctx->next_url_request_index++];
+      rv = callback.Run(ctx->original_response_headers,
+                        ctx->override_response_headers,
+                        ctx->allowed_unsafe_redirect_url, next_callback, ctx);
+      if (rv == net::ERR_IO_PENDING) {
+        return rv;
+      }
+      if (rv != net::OK) {
+        break;
+      }
+    }
+  }
+
+  return rv;
+}
+
+BraveRequestHandler::BraveRequestHandler()
+    : callback_chain_(base::MakeRefCounted<CallbackChain>()) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
   SetupCallbacks();
+  if (base::FeatureList::IsEnabled(
+          brave_shields::features::kBraveRequestHandlerSequence)) {
+    task_runner_ = base::CreateSequencedTaskRunner(
+        {base::ThreadPool(), base::TaskPriority::USER_BLOCKING,
+         base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN});
+  }
   // Initialize the preference change registrar.
   InitPrefChangeRegistrar();
 }
@@ -67,53 +185,63 @@ BraveRequestHandler::BraveRequestHandler() {
 BraveRequestHandler::~BraveRequestHandler() = default;
 
 void BraveRequestHandler::SetupCallbacks() {
-  brave::OnBeforeURLRequestCallback callback =
-      base::Bind(brave::OnBeforeURLRequest_SiteHacksWork);
-  before_url_request_callbacks_.push_back(callback);
-
-  callback = base::Bind(brave::OnBeforeURLRequest_AdBlockTPPreWork);
-  before_url_request_callbacks_.push_back(callback);
-
-  callback = base::Bind(brave::OnBeforeURLRequest_HttpsePreFileWork);
-  before_url_request_callbacks_.push_back(callback);
-
-  callback = base::Bind(brave::OnBeforeURLRequest_CommonStaticRedirectWork);
-  before_url_request_callbacks_.push_back(callback);
+  // Helpers which only read the request info, immutable or lock-protected
+  // globals, and the referral headers matcher snapshot run on the sequence.
+  callback_chain_->AddBeforeURLRequestCallback(
+      base::Bind(brave::OnBeforeURLRequest_SiteHacksWork),
+      CallbackThread::kSequence);
+
+  // Ad-block reads the CNAME cache and resolves hosts through the profile.
+  callback_chain_->AddBeforeURLRequestCallback(
+      base::Bind(brave::OnBeforeURLRequest_AdBlockTPPreWork),
+      CallbackThread::kUIThread);
+
+  // HTTPS Everywhere reads the state of its browser-wide service.
+  callback_chain_->AddBeforeURLRequestCallback(
+      base::Bind(brave::OnBeforeURLRequest_HttpsePreFileWork),
+      CallbackThread::kUIThread);
+
+  callback_chain_->AddBeforeURLRequestCallback(
+      base::Bind(brave::OnBeforeURLRequest_CommonStaticRedirectWork),
+      CallbackThread::kSequence);
 
 #if BUILDFLAG(BRAVE_REWARDS_ENABLED)
-  callback = base::Bind(brave_rewards::OnBeforeURLRequest);
-  before_url_request_callbacks_.push_back(callback);
+  // Rewards looks up the tab and the profile's rewards service.
+  callback_chain_->AddBeforeURLRequestCallback(
+      base::Bind(brave_rewards::OnBeforeURLRequest),
+      CallbackThread::kUIThread);
 #endif
 
 #if BUILDFLAG(ENABLE_BRAVE_TRANSLATE_GO)
-  callback =
-      base::BindRepeating(brave::OnBeforeURLRequest_TranslateRedirectWork);
-  before_url_request_callbacks_.push_back(callback);
+  callback_chain_->AddBeforeURLRequestCallback(
+      base::BindRepeating(brave::OnBeforeURLRequest_TranslateRedirectWork),
+      CallbackThread::kSequence);
 #endif
 
 #if BUILDFLAG(IPFS_ENABLED)
-  callback = base::BindRepeating(ipfs::OnBeforeURLRequest_IPFSRedirectWork);
-  before_url_request_callbacks_.push_back(callback);
+  callback_chain_->AddBeforeURLRequestCallback(
+      base::BindRepeating(ipfs::OnBeforeURLRequest_IPFSRedirectWork),
+      CallbackThread::kSequence);
 #endif
 
-  brave::OnBeforeStartTransactionCallback start_transaction_callback =
-      base::Bind(brave::OnBeforeStartTransaction_SiteHacksWork);
-  before_start_transaction_callbacks_.push_back(start_transaction_callback);
+  callback_chain_->AddBeforeStartTransactionCallback(
+      base::Bind(brave::OnBeforeStartTransaction_SiteHacksWork),
+      CallbackThread::kSequence);
 
-  start_transaction_callback =
-      base::Bind(brave::OnBeforeStartTransaction_GlobalPrivacyControlWork);
-  before_start_transaction_callbacks_.push_back(start_transaction_callback);
+  callback_chain_->AddBeforeStartTransactionCallback(
+      base::Bind(brave::OnBeforeStartTransaction_GlobalPrivacyControlWork),
+      CallbackThread::kSequence);
 
 #if BUILDFLAG(ENABLE_BRAVE_REFERRALS)
-  start_transaction_callback =
-      base::Bind(brave::OnBeforeStartTransaction_ReferralsWork);
-  before_start_transaction_callbacks_.push_back(start_transaction_callback);
+  callback_chain_->AddBeforeStartTransactionCallback(
+      base::Bind(brave::OnBeforeStartTransaction_ReferralsWork),
+      CallbackThread::kSequence);
 #endif
 
 #if BUILDFLAG(ENABLE_BRAVE_WEBTORRENT)
-  brave::OnHeadersReceivedCallback headers_received_callback =
-      base::Bind(webtorrent::OnHeadersReceived_TorrentRedirectWork);
-  headers_received_callbacks_.push_back(headers_received_callback);
+  callback_chain_->AddHeadersReceivedCallback(
+      base::Bind(webtorrent::OnHeadersReceived_TorrentRedirectWork),
+      CallbackThread::kSequence);
 #endif
 }
 
@@ -134,10 +262,13 @@ void BraveRequestHandler::InitPrefChangeRegistrar() {
 
 void BraveRequestHandler::OnReferralHeadersChanged() {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+#if BUILDFLAG(ENABLE_BRAVE_REFERRALS)
   if (const base::ListValue* referral_headers =
           g_browser_process->local_state()->GetList(kReferralHeaders)) {
-    referral_headers_list_.reset(referral_headers->DeepCopy());
+    referral_headers_matcher_ =
+        std::make_shared<brave::ReferralHeadersMatcher>(*referral_headers);
   }
+#endif
 }
 
 bool BraveRequestHandler::IsRequestIdentifierValid(
@@ -149,14 +280,15 @@ int BraveRequestHandler::OnBeforeURLRequest(
     std::shared_ptr<brave::BraveRequestInfo> ctx,
     net::CompletionOnceCallback callback,
     GURL* new_url) {
-  if (before_url_request_callbacks_.empty() || IsInternalScheme(ctx)) {
+  if (callback_chain_->before_url_request_callbacks.empty() ||
+      IsInternalScheme(ctx)) {
     return net::OK;
   }
   SCOPED_UMA_HISTOGRAM_TIMER("Brave.OnBeforeURLRequest_Handler");
   ctx->new_url = new_url;
   ctx->event_type = brave::kOnBeforeRequest;
   callbacks_[ctx->request_identifier] = std::move(callback);
-  RunNextCallback(ctx);
+  StartCallbacks(ctx);
   return net::ERR_IO_PENDING;
 }
 
@@ -164,14 +296,16 @@ int BraveRequestHandler::OnBeforeStartTransaction(
     std::shared_ptr<brave::BraveRequestInfo> ctx,
     net::CompletionOnceCallback callback,
     net::HttpRequestHeaders* headers) {
-  if (before_start_transaction_callbacks_.empty() || IsInternalScheme(ctx)) {
+  if (callback_chain_->before_start_transaction_callbacks.empty() ||
+      IsInternalScheme(ctx)) {
     return net::OK;
   }
   ctx->event_type = brave::kOnBeforeStartTransaction;
   ctx->headers = headers;
-  ctx->referral_headers_list = referral_headers_list_.get();
+  ctx->referral_headers_matcher = referral_headers_matcher_.get();
+  ctx->referral_headers_matcher_snapshot = referral_headers_matcher_;
   callbacks_[ctx->request_identifier] = std::move(callback);
-  RunNextCallback(ctx);
+  StartCallbacks(ctx);
   return net::ERR_IO_PENDING;
 }
 
@@ -187,7 +321,7 @@ int BraveRequestHandler::OnHeadersReceived(
         original_response_headers, override_response_headers);
   }
 
-  if (headers_received_callbacks_.empty() &&
+  if (callback_chain_->headers_received_callbacks.empty() &&
       !ctx->request_url.SchemeIs(content::kChromeUIScheme)) {
     // Extension scheme not excluded since brave_webtorrent needs it.
     return net::OK;
@@ -199,7 +333,7 @@ int BraveRequestHandler::OnHeadersReceived(
   ctx->override_response_headers = override_response_headers;
   ctx->allowed_unsafe_redirect_url = allowed_unsafe_redirect_url;
 
-  RunNextCallback(ctx);
+  StartCallbacks(ctx);
   return net::ERR_IO_PENDING;
 }
 
@@ -221,8 +355,20 @@ void BraveRequestHandler::RunCallbackForRequestIdentifier(
                  base::BindOnce(std::move(it->second), rv));
 }
 
-// TODO(iefremov): Merge all callback containers into one and run only one loop
-// instead of many (issues/5574).
+void BraveRequestHandler::StartCallbacks(
+    std::shared_ptr<brave::BraveRequestInfo> ctx) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  if (!task_runner_) {
+    RunNextCallback(ctx);
+    return;
+  }
+
+  // The request can be destroyed while its callbacks run on |task_runner_|,
+  // so they work on copies of what the network stack asked to fill in.
+  ctx->DetachOutParameters();
+  RunNextCallback(ctx);
+}
+
 void BraveRequestHandler::RunNextCallback(
     std::shared_ptr<brave::BraveRequestInfo> ctx) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
@@ -231,58 +377,80 @@ void BraveRequestHandler::RunNextCallback(
     return;
   }
 
-  // Continue processing callbacks until we hit one that returns PENDING
-  int rv = net::OK;
+  brave::ResponseCallback next_callback = base::Bind(
+      &BraveRequestHandler::RunNextCallback, weak_factory_.GetWeakPtr(), ctx);
+  base::Optional<CallbackThread> thread;
+  if (task_runner_) {
+    thread = CallbackThread::kUIThread;
+  }
+  bool switch_thread = false;
+  int rv = callback_chain_->Run(next_callback, ctx, thread, &switch_thread);
+  if (switch_thread) {
+    PostNextCallbackToSequence(callback_chain_, task_runner_,
+                               weak_factory_.GetWeakPtr(), ctx);
+    return;
+  }
+  if (rv == net::ERR_IO_PENDING) {
+    return;
+  }
 
-  if (ctx->event_type == brave::kOnBeforeRequest) {
-    while (before_url_request_callbacks_.size() !=
-           ctx->next_url_request_index) {
-      brave::OnBeforeURLRequestCallback callback =
-          before_url_request_callbacks_[ctx->next_url_request_index++];
-      brave::ResponseCallback next_callback =
-          base::Bind(&BraveRequestHandler::RunNextCallback,
-                     weak_factory_.GetWeakPtr(), ctx);
-      rv = callback.Run(next_callback, ctx);
-      if (rv == net::ERR_IO_PENDING) {
-        return;
-      }
-      if (rv != net::OK) {
-        break;
-      }
-    }
-  } else if (ctx->event_type == brave::kOnBeforeStartTransaction) {
-    while (before_start_transaction_callbacks_.size() !=
-           ctx->next_url_request_index) {
-      brave::OnBeforeStartTransactionCallback callback =
-          before_start_transaction_callbacks_[ctx->next_url_request_index++];
-      brave::ResponseCallback next_callback =
-          base::Bind(&BraveRequestHandler::RunNextCallback,
-                     weak_factory_.GetWeakPtr(), ctx);
-      rv = callback.Run(ctx->headers, next_callback, ctx);
-      if (rv == net::ERR_IO_PENDING) {
-        return;
-      }
-      if (rv != net::OK) {
-        break;
-      }
-    }
-  } else if (ctx->event_type == brave::kOnHeadersReceived) {
-    while (headers_received_callbacks_.size() != ctx->next_url_request_index) {
-      brave::OnHeadersReceivedCallback callback =
-          headers_received_callbacks_[ctx->next_url_request_index++];
-      brave::ResponseCallback next_callback =
-          base::Bind(&BraveRequestHandler::RunNextCallback,
-                     weak_factory_.GetWeakPtr(), ctx);
-      rv = callback.Run(ctx->original_response_headers,
-                        ctx->override_response_headers,
-                        ctx->allowed_unsafe_redirect_url, next_callback, ctx);
-      if (rv == net::ERR_IO_PENDING) {
-        return;
-      }
-      if (rv != net::OK) {
-        break;
-      }
-    }
+  OnCallbacksComplete(ctx, rv);
+}
+
+// static
+void BraveRequestHandler::RunNextCallbackOnSequence(
+    scoped_refptr<CallbackChain> callback_chain,
+    scoped_refptr<base::SequencedTaskRunner> task_runner,
+    base::WeakPtr<BraveRequestHandler> request_handler,
+    std::shared_ptr<brave::BraveRequestInfo> ctx) {
+  DCHECK(task_runner->RunsTasksInCurrentSequence());
+
+  // Callbacks which go to the UI thread or to another task runner can resume
+  // from there, so the next one is always posted back to |task_runner|.
+  brave::ResponseCallback next_callback =
+      base::Bind(&BraveRequestHandler::PostNextCallbackToSequence,
+                 callback_chain, task_runner, request_handler, ctx);
+  bool switch_thread = false;
+  int rv = callback_chain->Run(next_callback, ctx, CallbackThread::kSequence,
+                               &switch_thread);
+  if (switch_thread) {
+    base::PostTask(FROM_HERE, {content::BrowserThread::UI},
+                   base::BindOnce(&BraveRequestHandler::RunNextCallback,
+                                  request_handler, ctx));
+    return;
+  }
+  if (rv == net::ERR_IO_PENDING) {
+    return;
+  }
+
+  base::PostTask(FROM_HERE, {content::BrowserThread::UI},
+                 base::BindOnce(&BraveRequestHandler::OnCallbacksComplete,
+                                request_handler, ctx, rv));
+}
+
+// static
+void BraveRequestHandler::PostNextCallbackToSequence(
+    scoped_refptr<CallbackChain> callback_chain,
+    scoped_refptr<base::SequencedTaskRunner> task_runner,
+    base::WeakPtr<BraveRequestHandler> request_handler,
+    std::shared_ptr<brave::BraveRequestInfo> ctx) {
+  task_runner->PostTask(
+      FROM_HERE, base::BindOnce(&BraveRequestHandler::RunNextCallbackOnSequence,
+                                callback_chain, task_runner, request_handler,
+                                ctx));
+}
+
+void BraveRequestHandler::OnCallbacksComplete(
+    std::shared_ptr<brave::BraveRequestInfo> ctx,
+    int rv) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+  if (!IsRequestIdentifierValid(ctx->request_identifier)) {
+    return;
+  }
+
+  if (task_runner_) {
+    ctx->ReattachOutParameters();
   }
 
   if (rv != net::OK) {
@@ -292,8 +460,7 @@ void BraveRequestHandler::RunNextCallback(
 
   if (ctx->event_type == brave::kOnBeforeRequest) {
     if (!ctx->new_url_spec.empty() &&
-        (ctx->new_url_spec != ctx->request_url.spec()) &&
-        IsRequestIdentifierValid(ctx->request_identifier)) {
+        (ctx->new_url_spec != ctx->request_url.spec())) {
       *ctx->new_url = GURL(ctx->new_url_spec);
     }
     if (ctx->blocked_by == brave::kAdBlocked) {
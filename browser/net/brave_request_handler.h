@@ -11,12 +11,19 @@
 #include <string>
 #include <vector>
 
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/optional.h"
 #include "brave/browser/net/url_context.h"
 #include "content/public/browser/browser_thread.h"
 #include "net/base/completion_once_callback.h"
 
 class PrefChangeRegistrar;
 
+namespace base {
+class SequencedTaskRunner;
+}  // namespace base
+
 // Contains different network stack hooks (similar to capabilities of WebRequest
 // API).
 class BraveRequestHandler {
@@ -46,25 +53,98 @@ class BraveRequestHandler {
   void RunCallbackForRequestIdentifier(uint64_t request_identifier, int rv);
 
  private:
+  // Where a callback runs. Only callbacks which read nothing but the request
+  // info and state that is safe to read from any thread run on
+  // |task_runner_|. The rest read profile state, content settings or browser
+  // services, which live on the UI thread.
+  enum class CallbackThread {
+    kSequence,
+    kUIThread,
+  };
+
+  // The callbacks run for each event, which are set up once and then shared
+  // with the tasks running them on |task_runner_|.
+  struct CallbackChain : public base::RefCountedThreadSafe<CallbackChain> {
+    CallbackChain();
+
+    // Runs the callbacks for |ctx->event_type| starting from
+    // |ctx->next_url_request_index| until one of them returns PENDING, in
+    // which case it runs |next_callback| once done. When |thread| is set, it
+    // stops before the first callback which runs elsewhere and sets
+    // |*switch_thread|.
+    int Run(const brave::ResponseCallback& next_callback,
+            std::shared_ptr<brave::BraveRequestInfo> ctx,
+            base::Optional<CallbackThread> thread,
+            bool* switch_thread) const;
+
+    void AddBeforeURLRequestCallback(
+        const brave::OnBeforeURLRequestCallback& callback,
+        CallbackThread thread);
+    void AddBeforeStartTransactionCallback(
+        const brave::OnBeforeStartTransactionCallback& callback,
+        CallbackThread thread);
+    void AddHeadersReceivedCallback(
+        const brave::OnHeadersReceivedCallback& callback,
+        CallbackThread thread);
+
+    std::vector<brave::OnBeforeURLRequestCallback>
+        before_url_request_callbacks;
+    std::vector<brave::OnBeforeStartTransactionCallback>
+        before_start_transaction_callbacks;
+    std::vector<brave::OnHeadersReceivedCallback> headers_received_callbacks;
+
+   private:
+    friend class base::RefCountedThreadSafe<CallbackChain>;
+    ~CallbackChain();
+
+    // Returns where the next callback for |ctx| runs.
+    CallbackThread GetNextCallbackThread(
+        std::shared_ptr<brave::BraveRequestInfo> ctx) const;
+
+    std::vector<CallbackThread> before_url_request_threads_;
+    std::vector<CallbackThread> before_start_transaction_threads_;
+    std::vector<CallbackThread> headers_received_threads_;
+
+    DISALLOW_COPY_AND_ASSIGN(CallbackChain);
+  };
+
+  static void RunNextCallbackOnSequence(
+      scoped_refptr<CallbackChain> callback_chain,
+      scoped_refptr<base::SequencedTaskRunner> task_runner,
+      base::WeakPtr<BraveRequestHandler> request_handler,
+      std::shared_ptr<brave::BraveRequestInfo> ctx);
+  static void PostNextCallbackToSequence(
+      scoped_refptr<CallbackChain> callback_chain,
+      scoped_refptr<base::SequencedTaskRunner> task_runner,
+      base::WeakPtr<BraveRequestHandler> request_handler,
+      std::shared_ptr<brave::BraveRequestInfo> ctx);
+
   void SetupCallbacks();
   void InitPrefChangeRegistrar();
   void OnReferralHeadersChanged();
   void OnPreferenceChanged(const std::string& pref_name);
   void UpdateAdBlockFromPref(const std::string& pref_name);
 
+  void StartCallbacks(std::shared_ptr<brave::BraveRequestInfo> ctx);
   void RunNextCallback(std::shared_ptr<brave::BraveRequestInfo> ctx);
+  void OnCallbacksComplete(std::shared_ptr<brave::BraveRequestInfo> ctx,
+                           int rv);
+
+  scoped_refptr<CallbackChain> callback_chain_;
 
-  std::vector<brave::OnBeforeURLRequestCallback> before_url_request_callbacks_;
-  std::vector<brave::OnBeforeStartTransactionCallback>
-      before_start_transaction_callbacks_;
-  std::vector<brave::OnHeadersReceivedCallback> headers_received_callbacks_;
+  // Set when the callbacks run on a sequence of the thread pool rather than
+  // on the UI thread.
+  scoped_refptr<base::SequencedTaskRunner> task_runner_;
 
   // TODO(iefremov): actually, we don't have to keep the list here, since
   // it is global for the whole browser and could live a singletonce in the
   // rewards service. Eliminating this will also help to avoid using
   // PrefChangeRegistrar and corresponding |base::Unretained| usages, that are
   // illegal.
-  std::unique_ptr<base::ListValue> referral_headers_list_;
+  // Requests keep the matcher they were given alive, since it is replaced when
+  // the referral headers change.
+  std::shared_ptr<const brave::ReferralHeadersMatcher>
+      referral_headers_matcher_;
   std::map<uint64_t, net::CompletionOnceCallback> callbacks_;
   std::unique_ptr<PrefChangeRegistrar, content::BrowserThread::DeleteOnUIThread>
       pref_change_registrar_;
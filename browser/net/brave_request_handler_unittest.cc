@@ -0,0 +1,168 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/browser/net/brave_request_handler.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/task/post_task.h"
+#include "base/test/bind_test_util.h"
+#include "base/test/scoped_feature_list.h"
+#include "base/threading/platform_thread.h"
+#include "base/timer/elapsed_timer.h"
+#include "brave/common/brave_features.h"
+#include "brave/common/network_constants.h"
+#include "brave/components/brave_shields/common/features.h"
+#include "chrome/test/base/scoped_testing_local_state.h"
+#include "chrome/test/base/testing_browser_process.h"
+#include "content/public/browser/browser_task_traits.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/test/browser_task_environment.h"
+#include "net/base/net_errors.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace {
+
+std::shared_ptr<brave::BraveRequestInfo> CreateRequestInfo(
+    const GURL& url,
+    uint64_t request_identifier) {
+  auto ctx = std::make_shared<brave::BraveRequestInfo>(url);
+  ctx->request_identifier = request_identifier;
+  return ctx;
+}
+
+}  // namespace
+
+class BraveRequestHandlerTest : public testing::Test {
+ public:
+  BraveRequestHandlerTest()
+      : local_state_(TestingBrowserProcess::GetGlobal()) {}
+  ~BraveRequestHandlerTest() override = default;
+
+ protected:
+  std::unique_ptr<BraveRequestHandler> CreateRequestHandler(bool on_sequence) {
+    base::test::ScopedFeatureList feature_list;
+    if (on_sequence) {
+      feature_list.InitAndEnableFeature(
+          brave_shields::features::kBraveRequestHandlerSequence);
+    } else {
+      feature_list.InitAndDisableFeature(
+          brave_shields::features::kBraveRequestHandlerSequence);
+    }
+    return std::make_unique<BraveRequestHandler>();
+  }
+
+  content::BrowserTaskEnvironment task_environment_;
+
+ private:
+  ScopedTestingLocalState local_state_;
+
+  DISALLOW_COPY_AND_ASSIGN(BraveRequestHandlerTest);
+};
+
+TEST_F(BraveRequestHandlerTest, RunsCallbacksOnSequence) {
+  auto request_handler = CreateRequestHandler(true);
+  auto ctx = CreateRequestInfo(GURL("https://brave.com/?fbclid=1234"), 1);
+
+  GURL new_url;
+  int result = net::ERR_IO_PENDING;
+  EXPECT_EQ(net::ERR_IO_PENDING,
+            request_handler->OnBeforeURLRequest(
+                ctx, base::BindLambdaForTesting([&](int rv) { result = rv; }),
+                &new_url));
+  task_environment_.RunUntilIdle();
+
+  EXPECT_EQ(net::OK, result);
+  EXPECT_EQ(GURL("https://brave.com/"), new_url);
+}
+
+TEST_F(BraveRequestHandlerTest, CopiesBackRequestHeadersFromSequence) {
+  base::test::ScopedFeatureList feature_list;
+  feature_list.InitAndEnableFeature(features::kGlobalPrivacyControl);
+  auto request_handler = CreateRequestHandler(true);
+  auto ctx = CreateRequestInfo(GURL("https://brave.com/"), 1);
+
+  net::HttpRequestHeaders headers;
+  int result = net::ERR_IO_PENDING;
+  EXPECT_EQ(net::ERR_IO_PENDING,
+            request_handler->OnBeforeStartTransaction(
+                ctx, base::BindLambdaForTesting([&](int rv) { result = rv; }),
+                &headers));
+  EXPECT_FALSE(headers.HasHeader(kSecGpcHeader));
+  task_environment_.RunUntilIdle();
+
+  EXPECT_EQ(net::OK, result);
+  EXPECT_TRUE(headers.HasHeader(kSecGpcHeader));
+}
+
+TEST_F(BraveRequestHandlerTest, DoesNotCompleteDestroyedRequestsOnSequence) {
+  auto request_handler = CreateRequestHandler(true);
+  auto ctx = CreateRequestInfo(GURL("https://brave.com/?fbclid=1234"), 1);
+
+  auto new_url = std::make_unique<GURL>();
+  bool completed = false;
+  request_handler->OnBeforeURLRequest(
+      ctx, base::BindLambdaForTesting([&](int rv) { completed = true; }),
+      new_url.get());
+  request_handler->OnURLRequestDestroyed(ctx);
+  new_url.reset();
+  task_environment_.RunUntilIdle();
+
+  EXPECT_FALSE(completed);
+}
+
+// Disabled by default, as it is a benchmark. Run it with
+// --gtest_also_run_disabled_tests.
+TEST_F(BraveRequestHandlerTest, DISABLED_RequestAdmissionBenchmark) {
+  const size_t kRequestCount = 500;
+  const base::TimeDelta kBusyTime = base::TimeDelta::FromMilliseconds(50);
+
+  for (const bool on_sequence : {false, true}) {
+    auto request_handler = CreateRequestHandler(on_sequence);
+    std::vector<GURL> new_urls(kRequestCount);
+    size_t completed_count = 0;
+    base::TimeDelta admission_time;
+
+    // Requests arrive while the UI thread is busy with something else.
+    base::ElapsedTimer timer;
+    base::PostTask(FROM_HERE, {content::BrowserThread::UI},
+                   base::BindOnce(&base::PlatformThread::Sleep, kBusyTime));
+    for (size_t i = 0; i < kRequestCount; ++i) {
+      const GURL url("https://example" + base::NumberToString(i) +
+                     ".com/?foo=1&fbclid=1234&bar=2");
+      auto ctx = CreateRequestInfo(url, i + 1);
+      base::PostTask(
+          FROM_HERE, {content::BrowserThread::UI},
+          base::BindLambdaForTesting([&, ctx, i]() {
+            base::ElapsedTimer admission_timer;
+            request_handler->OnBeforeURLRequest(
+                ctx,
+                base::BindLambdaForTesting([&](int rv) { completed_count++; }),
+                &new_urls[i]);
+            admission_time += admission_timer.Elapsed();
+          }));
+    }
+    task_environment_.RunUntilIdle();
+    const base::TimeDelta elapsed = timer.Elapsed();
+
+    EXPECT_EQ(kRequestCount, completed_count);
+    for (size_t i = 0; i < kRequestCount; ++i) {
+      EXPECT_EQ("https://example" + base::NumberToString(i) +
+                    ".com/?foo=1&bar=2",
+                new_urls[i].spec());
+    }
+
+    LOG(INFO) << (on_sequence ? "On sequence: " : "On the UI thread: ")
+              << kRequestCount << " requests held the UI thread for "
+              << admission_time.InMicroseconds() << "us and completed in "
+              << elapsed.InMicroseconds() << "us with the UI thread busy for "
+              << kBusyTime.InMicroseconds() << "us";
+  }
+}
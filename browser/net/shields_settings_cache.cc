@@ -0,0 +1,98 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/browser/net/shields_settings_cache.h"
+
+#include "base/bind.h"
+#include "brave/components/brave_shields/browser/brave_shields_util.h"
+#include "brave/components/ipfs/buildflags/buildflags.h"
+#include "components/content_settings/core/browser/host_content_settings_map.h"
+#include "components/prefs/pref_service.h"
+#include "content/public/browser/browser_thread.h"
+
+#if BUILDFLAG(IPFS_ENABLED)
+#include "brave/components/ipfs/ipfs_constants.h"
+#include "brave/components/ipfs/pref_names.h"
+#endif
+
+namespace brave {
+
+ShieldsSettingsCache::ShieldsSettingsCache(
+    HostContentSettingsMap* host_content_settings_map,
+    PrefService* prefs)
+    : host_content_settings_map_(host_content_settings_map),
+      prefs_(prefs),
+      snapshots_(kMaxEntries) {
+  host_content_settings_map_->AddObserver(this);
+#if BUILDFLAG(IPFS_ENABLED)
+  pref_change_registrar_.Init(prefs_);
+  pref_change_registrar_.Add(
+      kIPFSResolveMethod,
+      base::BindRepeating(&ShieldsSettingsCache::Invalidate,
+                          base::Unretained(this)));
+#endif
+}
+
+ShieldsSettingsCache::~ShieldsSettingsCache() {
+  host_content_settings_map_->RemoveObserver(this);
+}
+
+// static
+ShieldsSettingsSnapshot ShieldsSettingsCache::ComputeSnapshot(
+    HostContentSettingsMap* host_content_settings_map,
+    PrefService* prefs,
+    const GURL& tab_origin) {
+  ShieldsSettingsSnapshot snapshot;
+  snapshot.allow_brave_shields = brave_shields::GetBraveShieldsEnabled(
+      host_content_settings_map, tab_origin);
+  snapshot.allow_ads =
+      brave_shields::GetAdControlType(host_content_settings_map, tab_origin) ==
+      brave_shields::ControlType::ALLOW;
+  snapshot.allow_http_upgradable_resource =
+      !brave_shields::GetHTTPSEverywhereEnabled(host_content_settings_map,
+                                                tab_origin);
+  snapshot.allow_referrers =
+      brave_shields::AllowReferrers(host_content_settings_map, tab_origin);
+
+#if BUILDFLAG(IPFS_ENABLED)
+  snapshot.ipfs_local = static_cast<ipfs::IPFSResolveMethodTypes>(
+      prefs->GetInteger(kIPFSResolveMethod)) ==
+          ipfs::IPFSResolveMethodTypes::IPFS_LOCAL;
+#endif
+
+  return snapshot;
+}
+
+const ShieldsSettingsSnapshot& ShieldsSettingsCache::Get(
+    const GURL& tab_origin) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  auto it = snapshots_.Get(tab_origin);
+  if (it == snapshots_.end()) {
+    it = snapshots_.Put(
+        tab_origin,
+        ComputeSnapshot(host_content_settings_map_, prefs_, tab_origin));
+  }
+  return it->second;
+}
+
+void ShieldsSettingsCache::Invalidate() {
+  snapshots_.Clear();
+}
+
+void ShieldsSettingsCache::OnContentSettingChanged(
+    const ContentSettingsPattern& primary_pattern,
+    const ContentSettingsPattern& secondary_pattern,
+    ContentSettingsType content_type,
+    const std::string& resource_identifier) {
+  // Shields settings are stored as plugins settings. Rules can match any
+  // origin, so a change drops every snapshot rather than the matching ones.
+  if (content_type == ContentSettingsType::DEFAULT ||
+      content_type == ContentSettingsType::PLUGINS ||
+      content_type == ContentSettingsType::COOKIES) {
+    Invalidate();
+  }
+}
+
+}  // namespace brave
@@ -0,0 +1,76 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_BROWSER_NET_SHIELDS_SETTINGS_CACHE_H_
+#define BRAVE_BROWSER_NET_SHIELDS_SETTINGS_CACHE_H_
+
+#include <string>
+
+#include "base/containers/mru_cache.h"
+#include "base/macros.h"
+#include "components/content_settings/core/browser/content_settings_observer.h"
+#include "components/keyed_service/core/keyed_service.h"
+#include "components/prefs/pref_change_registrar.h"
+#include "url/gurl.h"
+
+class HostContentSettingsMap;
+class PrefService;
+
+namespace brave {
+
+// The shields settings for a top-frame origin which BraveRequestInfo::FillCTX
+// copies into the context of every request made by the frame.
+struct ShieldsSettingsSnapshot {
+  bool allow_brave_shields = true;
+  bool allow_ads = false;
+  bool allow_http_upgradable_resource = false;
+  bool allow_referrers = false;
+  bool ipfs_local = true;
+};
+
+// Per-profile cache of shields settings snapshots keyed by top-frame origin,
+// so the subresources of a page don't repeat the same content settings
+// lookups. All snapshots are dropped whenever shields content settings, which
+// includes the cookie rules notified by BravePrefProvider, or the IPFS resolve
+// method change. Lives on the UI thread.
+class ShieldsSettingsCache : public KeyedService,
+                             public content_settings::Observer {
+ public:
+  static constexpr size_t kMaxEntries = 100;
+
+  ShieldsSettingsCache(HostContentSettingsMap* host_content_settings_map,
+                       PrefService* prefs);
+  ~ShieldsSettingsCache() override;
+
+  // Computes the settings for |tab_origin| without caching them.
+  static ShieldsSettingsSnapshot ComputeSnapshot(
+      HostContentSettingsMap* host_content_settings_map,
+      PrefService* prefs,
+      const GURL& tab_origin);
+
+  const ShieldsSettingsSnapshot& Get(const GURL& tab_origin);
+
+  size_t size() const { return snapshots_.size(); }
+
+ private:
+  void Invalidate();
+
+  // content_settings::Observer overrides:
+  void OnContentSettingChanged(const ContentSettingsPattern& primary_pattern,
+                               const ContentSettingsPattern& secondary_pattern,
+                               ContentSettingsType content_type,
+                               const std::string& resource_identifier) override;
+
+  HostContentSettingsMap* host_content_settings_map_;
+  PrefService* prefs_;
+  PrefChangeRegistrar pref_change_registrar_;
+  base::MRUCache<GURL, ShieldsSettingsSnapshot> snapshots_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShieldsSettingsCache);
+};
+
+}  // namespace brave
+
+#endif  // BRAVE_BROWSER_NET_SHIELDS_SETTINGS_CACHE_H_
@@ -0,0 +1,40 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_BROWSER_NET_SHIELDS_SETTINGS_CACHE_FACTORY_H_
+#define BRAVE_BROWSER_NET_SHIELDS_SETTINGS_CACHE_FACTORY_H_
+
+#include "base/memory/singleton.h"
+#include "components/keyed_service/content/browser_context_keyed_service_factory.h"
+
+namespace brave {
+
+class ShieldsSettingsCache;
+
+class ShieldsSettingsCacheFactory : public BrowserContextKeyedServiceFactory {
+ public:
+  static ShieldsSettingsCache* GetForBrowserContext(
+      content::BrowserContext* context);
+
+  static ShieldsSettingsCacheFactory* GetInstance();
+
+ private:
+  friend struct base::DefaultSingletonTraits<ShieldsSettingsCacheFactory>;
+
+  ShieldsSettingsCacheFactory();
+  ~ShieldsSettingsCacheFactory() override;
+
+  // BrowserContextKeyedServiceFactory overrides:
+  KeyedService* BuildServiceInstanceFor(
+      content::BrowserContext* context) const override;
+  content::BrowserContext* GetBrowserContextToUse(
+      content::BrowserContext* context) const override;
+
+  DISALLOW_COPY_AND_ASSIGN(ShieldsSettingsCacheFactory);
+};
+
+}  // namespace brave
+
+#endif  // BRAVE_BROWSER_NET_SHIELDS_SETTINGS_CACHE_FACTORY_H_
@@ -0,0 +1,138 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/browser/net/shields_settings_cache.h"
+
+#include <memory>
+
+#include "base/logging.h"
+#include "base/timer/elapsed_timer.h"
+#include "brave/components/brave_shields/browser/brave_shields_util.h"
+#include "brave/components/ipfs/buildflags/buildflags.h"
+#include "chrome/browser/content_settings/host_content_settings_map_factory.h"
+#include "chrome/test/base/testing_profile.h"
+#include "components/content_settings/core/browser/host_content_settings_map.h"
+#include "components/prefs/pref_service.h"
+#include "content/public/test/browser_task_environment.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+#if BUILDFLAG(IPFS_ENABLED)
+#include "brave/components/ipfs/ipfs_constants.h"
+#include "brave/components/ipfs/pref_names.h"
+#endif
+
+namespace brave {
+
+class ShieldsSettingsCacheTest : public testing::Test {
+ public:
+  ShieldsSettingsCacheTest() = default;
+  ~ShieldsSettingsCacheTest() override = default;
+
+  void SetUp() override {
+    profile_ = std::make_unique<TestingProfile>();
+    cache_ = std::make_unique<ShieldsSettingsCache>(map(),
+                                                    profile_->GetPrefs());
+  }
+
+  void TearDown() override { cache_.reset(); }
+
+  HostContentSettingsMap* map() {
+    return HostContentSettingsMapFactory::GetForProfile(profile_.get());
+  }
+
+  PrefService* prefs() { return profile_->GetPrefs(); }
+
+  ShieldsSettingsCache* cache() { return cache_.get(); }
+
+ private:
+  content::BrowserTaskEnvironment task_environment_;
+  std::unique_ptr<TestingProfile> profile_;
+  std::unique_ptr<ShieldsSettingsCache> cache_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShieldsSettingsCacheTest);
+};
+
+TEST_F(ShieldsSettingsCacheTest, CachesSnapshotPerOrigin) {
+  const GURL origin("https://brave.com/");
+  brave_shields::SetAdControlType(map(), brave_shields::ControlType::ALLOW,
+                                  origin);
+
+  EXPECT_TRUE(cache()->Get(origin).allow_ads);
+  EXPECT_TRUE(cache()->Get(origin).allow_ads);
+  EXPECT_EQ(1u, cache()->size());
+
+  EXPECT_FALSE(cache()->Get(GURL("https://example.com/")).allow_ads);
+  EXPECT_EQ(2u, cache()->size());
+}
+
+TEST_F(ShieldsSettingsCacheTest, MatchesComputedSnapshot) {
+  const GURL origin("https://brave.com/");
+  brave_shields::SetBraveShieldsEnabled(map(), false, origin);
+  brave_shields::SetHTTPSEverywhereEnabled(map(), false, origin);
+  // Referrers are set along with cookies.
+  brave_shields::SetCookieControlType(map(), brave_shields::ControlType::ALLOW,
+                                      origin);
+
+  const ShieldsSettingsSnapshot expected =
+      ShieldsSettingsCache::ComputeSnapshot(map(), prefs(), origin);
+  const ShieldsSettingsSnapshot& snapshot = cache()->Get(origin);
+  EXPECT_FALSE(snapshot.allow_brave_shields);
+  EXPECT_EQ(expected.allow_brave_shields, snapshot.allow_brave_shields);
+  EXPECT_EQ(expected.allow_ads, snapshot.allow_ads);
+  EXPECT_EQ(expected.allow_http_upgradable_resource,
+            snapshot.allow_http_upgradable_resource);
+  EXPECT_EQ(expected.allow_referrers, snapshot.allow_referrers);
+  EXPECT_EQ(expected.ipfs_local, snapshot.ipfs_local);
+}
+
+TEST_F(ShieldsSettingsCacheTest, ContentSettingsChangeInvalidates) {
+  const GURL origin("https://brave.com/");
+  EXPECT_TRUE(cache()->Get(origin).allow_brave_shields);
+  EXPECT_EQ(1u, cache()->size());
+
+  brave_shields::SetBraveShieldsEnabled(map(), false, origin);
+  EXPECT_EQ(0u, cache()->size());
+  EXPECT_FALSE(cache()->Get(origin).allow_brave_shields);
+}
+
+#if BUILDFLAG(IPFS_ENABLED)
+TEST_F(ShieldsSettingsCacheTest, IPFSResolveMethodChangeInvalidates) {
+  prefs()->SetInteger(
+      kIPFSResolveMethod,
+      static_cast<int>(ipfs::IPFSResolveMethodTypes::IPFS_LOCAL));
+  const GURL origin("https://brave.com/");
+  EXPECT_TRUE(cache()->Get(origin).ipfs_local);
+
+  prefs()->SetInteger(
+      kIPFSResolveMethod,
+      static_cast<int>(ipfs::IPFSResolveMethodTypes::IPFS_GATEWAY));
+  EXPECT_EQ(0u, cache()->size());
+  EXPECT_FALSE(cache()->Get(origin).ipfs_local);
+}
+#endif
+
+// Disabled by default, as it is a benchmark. Run it with
+// --gtest_also_run_disabled_tests.
+TEST_F(ShieldsSettingsCacheTest, DISABLED_SubresourceLookupBenchmark) {
+  // A page loading a few hundred subresources.
+  const GURL origin("https://brave.com/");
+  const int kRequestCount = 300;
+
+  base::ElapsedTimer compute_timer;
+  for (int i = 0; i < kRequestCount; ++i)
+    ShieldsSettingsCache::ComputeSnapshot(map(), prefs(), origin);
+  const base::TimeDelta compute_elapsed = compute_timer.Elapsed();
+
+  base::ElapsedTimer cache_timer;
+  for (int i = 0; i < kRequestCount; ++i)
+    cache()->Get(origin);
+  const base::TimeDelta cache_elapsed = cache_timer.Elapsed();
+
+  LOG(INFO) << kRequestCount << " requests read shields settings in "
+            << cache_elapsed.InMicroseconds() << "us from snapshots vs "
+            << compute_elapsed.InMicroseconds() << "us looking them up";
+}
+
+}  // namespace brave
@@ -7,34 +7,37 @@
 
 #include <memory>
 #include <string>
+#include <utility>
 
-#include "brave/components/brave_shields/browser/brave_shields_util.h"
+#include "base/feature_list.h"
+#include "base/metrics/histogram_macros.h"
+#include "base/timer/elapsed_timer.h"
+#include "brave/browser/net/shields_settings_cache.h"
+#include "brave/browser/net/shields_settings_cache_factory.h"
 #include "brave/components/brave_shields/browser/brave_shields_web_contents_observer.h"
+#include "brave/components/brave_shields/common/features.h"
 #include "brave/components/brave_webtorrent/browser/buildflags/buildflags.h"
 #include "brave/components/brave_webtorrent/browser/webtorrent_util.h"
-#include "brave/components/ipfs/buildflags/buildflags.h"
 #include "chrome/browser/content_settings/host_content_settings_map_factory.h"
 #include "chrome/browser/profiles/profile.h"
+#include "components/user_prefs/user_prefs.h"
 #include "content/public/browser/browser_thread.h"
 #include "net/base/isolation_info.h"
 
-#if BUILDFLAG(IPFS_ENABLED)
-#include "brave/components/ipfs/pref_names.h"
-#include "brave/components/ipfs/ipfs_constants.h"
-#include "components/prefs/testing_pref_service.h"
-#include "components/user_prefs/user_prefs.h"
-#endif
-
 namespace brave {
 
-namespace {
+BraveRequestInfo::BraveRequestInfo() = default;
+
+BraveRequestInfo::BraveRequestInfo(const GURL& url) : request_url(url) {}
 
-std::string GetUploadData(const network::ResourceRequest& request) {
+BraveRequestInfo::~BraveRequestInfo() = default;
+
+std::string BraveRequestInfo::GetUploadData() const {
   std::string upload_data;
-  if (!request.request_body) {
+  if (!request_body) {
     return {};
   }
-  const auto* elements = request.request_body->elements();
+  const auto* elements = request_body->elements();
   for (const network::DataElement& element : *elements) {
     if (element.type() == network::mojom::DataElementType::kBytes) {
       upload_data.append(element.bytes(), element.length());
@@ -44,13 +47,46 @@ std::string GetUploadData(const network::ResourceRequest& request) {
   return upload_data;
 }
 
-}  // namespace
-
-BraveRequestInfo::BraveRequestInfo() = default;
-
-BraveRequestInfo::BraveRequestInfo(const GURL& url) : request_url(url) {}
+void BraveRequestInfo::DetachOutParameters() {
+  if (headers) {
+    attached_headers = headers;
+    detached_headers = *headers;
+    headers = &detached_headers;
+  }
+  if (original_response_headers) {
+    detached_original_response_headers = original_response_headers;
+  }
+  if (override_response_headers) {
+    attached_override_response_headers = override_response_headers;
+    detached_override_response_headers = *override_response_headers;
+    override_response_headers = &detached_override_response_headers;
+  }
+  if (allowed_unsafe_redirect_url) {
+    attached_allowed_unsafe_redirect_url = allowed_unsafe_redirect_url;
+    detached_allowed_unsafe_redirect_url = *allowed_unsafe_redirect_url;
+    allowed_unsafe_redirect_url = &detached_allowed_unsafe_redirect_url;
+  }
+}
 
-BraveRequestInfo::~BraveRequestInfo() = default;
+void BraveRequestInfo::ReattachOutParameters() {
+  if (attached_headers) {
+    *attached_headers = detached_headers;
+    headers = attached_headers;
+    attached_headers = nullptr;
+  }
+  if (attached_override_response_headers) {
+    *attached_override_response_headers =
+        std::move(detached_override_response_headers);
+    override_response_headers = attached_override_response_headers;
+    attached_override_response_headers = nullptr;
+  }
+  if (attached_allowed_unsafe_redirect_url) {
+    *attached_allowed_unsafe_redirect_url =
+        detached_allowed_unsafe_redirect_url;
+    allowed_unsafe_redirect_url = attached_allowed_unsafe_redirect_url;
+    attached_allowed_unsafe_redirect_url = nullptr;
+  }
+}
 
 // static
 void BraveRequestInfo::FillCTX(const network::ResourceRequest& request,
@@ -61,6 +97,7 @@ void BraveRequestInfo::FillCTX(const network::ResourceRequest& request,
                                std::shared_ptr<brave::BraveRequestInfo> old_ctx,
                                std::shared_ptr<brave::BraveRequestInfo> ctx) {
   DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  base::ElapsedTimer timer;
   ctx->request_identifier = request_identifier;
   ctx->request_url = request.url;
   // TODO(iefremov): Replace GURL with Origin
@@ -109,23 +146,23 @@ void BraveRequestInfo::FillCTX(const network::ResourceRequest& request,
                               .GetOrigin();
   }
 
-  Profile* profile = Profile::FromBrowserContext(browser_context);
-  auto* map = HostContentSettingsMapFactory::GetForProfile(profile);
-  ctx->allow_brave_shields =
-      brave_shields::GetBraveShieldsEnabled(map, ctx->tab_origin);
-  ctx->allow_ads = brave_shields::GetAdControlType(
-      map, ctx->tab_origin) == brave_shields::ControlType::ALLOW;
-  ctx->allow_http_upgradable_resource =
-      !brave_shields::GetHTTPSEverywhereEnabled(map, ctx->tab_origin);
-  ctx->allow_referrers = brave_shields::AllowReferrers(map, ctx->tab_origin);
-  ctx->upload_data = GetUploadData(request);
-
-#if BUILDFLAG(IPFS_ENABLED)
-  auto* prefs = user_prefs::UserPrefs::Get(browser_context);
-  ctx->ipfs_local = static_cast<ipfs::IPFSResolveMethodTypes>(
-      prefs->GetInteger(kIPFSResolveMethod)) ==
-          ipfs::IPFSResolveMethodTypes::IPFS_LOCAL;
-#endif
+  ShieldsSettingsSnapshot snapshot;
+  if (base::FeatureList::IsEnabled(
+          brave_shields::features::kBraveShieldsSettingsCache)) {
+    snapshot = ShieldsSettingsCacheFactory::GetForBrowserContext(
+                   browser_context)->Get(ctx->tab_origin);
+  } else {
+    snapshot = ShieldsSettingsCache::ComputeSnapshot(
+        HostContentSettingsMapFactory::GetForProfile(
+            Profile::FromBrowserContext(browser_context)),
+        user_prefs::UserPrefs::Get(browser_context), ctx->tab_origin);
+  }
+  ctx->allow_brave_shields = snapshot.allow_brave_shields;
+  ctx->allow_ads = snapshot.allow_ads;
+  ctx->allow_http_upgradable_resource = snapshot.allow_http_upgradable_resource;
+  ctx->allow_referrers = snapshot.allow_referrers;
+  ctx->ipfs_local = snapshot.ipfs_local;
+  ctx->request_body = request.request_body;
 
   // TODO(fmarier): remove this once the hacky code in
   // brave_proxying_url_loader_factory.cc is refactored. See
@@ -134,6 +171,11 @@ void BraveRequestInfo::FillCTX(const network::ResourceRequest& request,
     ctx->internal_redirect = old_ctx->internal_redirect;
     ctx->redirect_source = old_ctx->redirect_source;
   }
+
+  UMA_HISTOGRAM_CUSTOM_MICROSECONDS_TIMES(
+      "Brave.RequestInfo.FillCTX", timer.Elapsed(),
+      base::TimeDelta::FromMicroseconds(1), base::TimeDelta::FromSeconds(1),
+      50);
 }
 
 }  // namespace brave
@@ -14,6 +14,7 @@
 #include "net/http/http_request_headers.h"
 #include "net/http/http_response_headers.h"
 #include "net/url_request/referrer_policy.h"
+#include "services/network/public/cpp/resource_request_body.h"
 #include "third_party/blink/public/mojom/loader/resource_load_info.mojom-shared.h"
 #include "url/gurl.h"
 
@@ -28,6 +29,7 @@ struct ResourceRequest;
 }
 
 namespace brave {
+class ReferralHeadersMatcher;
 struct BraveRequestInfo;
 using ResponseCallback = base::Callback<void()>;
 }  // namespace brave
@@ -57,6 +59,10 @@ struct BraveRequestInfo {
   explicit BraveRequestInfo(const GURL& url);
 
   ~BraveRequestInfo();
+
+  // Returns the bytes elements of |request_body| concatenated.
+  std::string GetUploadData() const;
+
   GURL request_url;
   GURL tab_origin;
   GURL tab_url;
@@ -92,7 +98,7 @@ struct BraveRequestInfo {
 
   GURL* allowed_unsafe_redirect_url = nullptr;
   BraveNetworkDelegateEventType event_type = kUnknownEventType;
-  const base::ListValue* referral_headers_list = nullptr;
+  const ReferralHeadersMatcher* referral_headers_matcher = nullptr;
   BlockedBy blocked_by = kNotBlocked;
   bool cancel_request_explicitly = false;
   std::string mock_data_url;
@@ -108,7 +114,9 @@ struct BraveRequestInfo {
       static_cast<blink::mojom::ResourceType>(-1);
   blink::mojom::ResourceType resource_type = kInvalidResourceType;
 
-  std::string upload_data;
+  // Shared with the request rather than copied, since the body is only
+  // needed for a few requests. See GetUploadData().
+  scoped_refptr<network::ResourceRequestBody> request_body;
 
   static void FillCTX(const network::ResourceRequest& request,
                       int render_process_id,
@@ -123,8 +131,27 @@ struct BraveRequestInfo {
   // We should also remove the one below.
   friend class ::BraveRequestHandler;
 
+  // Point the out parameters of the network stack hooks at copies owned by
+  // the request info, and write the copies back once the callbacks are done.
+  void DetachOutParameters();
+  void ReattachOutParameters();
+
   GURL* new_url = nullptr;
 
+  std::shared_ptr<const ReferralHeadersMatcher>
+      referral_headers_matcher_snapshot;
+
+  // The out parameters while detached.
+  net::HttpRequestHeaders* attached_headers = nullptr;
+  net::HttpRequestHeaders detached_headers;
+  scoped_refptr<const net::HttpResponseHeaders>
+      detached_original_response_headers;
+  scoped_refptr<net::HttpResponseHeaders>* attached_override_response_headers =
+      nullptr;
+  scoped_refptr<net::HttpResponseHeaders> detached_override_response_headers;
+  GURL* attached_allowed_unsafe_redirect_url = nullptr;
+  GURL detached_allowed_unsafe_redirect_url;
+
   DISALLOW_COPY_AND_ASSIGN(BraveRequestInfo);
 };
 
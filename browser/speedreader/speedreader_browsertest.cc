@@ -3,8 +3,12 @@
  * License, v. 2.0. If a copy of the MPL was not distributed with this file,
  * You can obtain one at http://mozilla.org/MPL/2.0/. */
 
+#include <memory>
+
 #include "base/bind.h"
 #include "base/path_service.h"
+#include "base/test/metrics/histogram_tester.h"
+#include "base/test/scoped_feature_list.h"
 #include "brave/app/brave_command_ids.h"
 #include "brave/common/brave_paths.h"
 #include "brave/components/speedreader/features.h"
@@ -18,6 +22,8 @@
 #include "content/public/test/browser_test_utils.h"
 #include "net/dns/mock_host_resolver.h"
 #include "net/test/embedded_test_server/embedded_test_server.h"
+#include "net/test/embedded_test_server/http_request.h"
+#include "net/test/embedded_test_server/http_response.h"
 
 const char kTestHost[] = "theguardian.com";
 const char kTestPage[] = "/guardian.html";
@@ -30,6 +36,47 @@ constexpr char kSpeedreaderToggleUMAHistogramName[] =
 constexpr char kSpeedreaderEnabledUMAHistogramName[] =
     "Brave.SpeedReader.Enabled";
 
+constexpr char kTimeToFirstByteUMAHistogramName[] =
+    "Brave.Speedreader.TimeToFirstByte";
+
+// Pages served to exercise the loader's fallbacks to the original body.
+const char kShortPage[] = "/speedreader_short.html";
+const char kDistillFailurePage[] = "/speedreader_distill_failure.html";
+const char kAbortedPage[] = "/speedreader_aborted.html";
+
+const char kHasSpeedreaderStyle[] =
+    "!!document.getElementById(\"brave_speedreader_style\")";
+
+std::unique_ptr<net::test_server::HttpResponse> HandleLoaderTestRequest(
+    const net::test_server::HttpRequest& request) {
+  if (request.relative_url == kShortPage) {
+    auto response = std::make_unique<net::test_server::BasicHttpResponse>();
+    response->set_content_type("text/html");
+    response->set_content(
+        "<html><body><div class=\"content__article-body\">"
+        "<p id=\"short\">Too short to distill</p></div></body></html>");
+    return response;
+  }
+  if (request.relative_url == kDistillFailurePage) {
+    // The rewriter fails on this ambiguous markup.
+    auto response = std::make_unique<net::test_server::BasicHttpResponse>();
+    response->set_content_type("text/html");
+    response->set_content(
+        "<select><div><style><div></div></style></div></select>"
+        "<p id=\"original\">Original</p>");
+    return response;
+  }
+  if (request.relative_url == kAbortedPage) {
+    // The connection is closed long before the promised length is sent.
+    return std::make_unique<net::test_server::RawHttpResponse>(
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/html\r\n"
+        "Content-Length: 100000\r\n",
+        "<html><body><p id=\"partial\">Partial</p>");
+  }
+  return nullptr;
+}
+
 class SpeedReaderBrowserTest : public InProcessBrowserTest {
  public:
   SpeedReaderBrowserTest()
@@ -39,6 +86,8 @@ class SpeedReaderBrowserTest : public InProcessBrowserTest {
     base::FilePath test_data_dir;
     base::PathService::Get(brave::DIR_TEST_DATA, &test_data_dir);
     https_server_.SetSSLConfig(net::EmbeddedTestServer::CERT_OK);
+    https_server_.RegisterRequestHandler(
+        base::BindRepeating(&HandleLoaderTestRequest));
     https_server_.ServeFilesFromDirectory(test_data_dir);
     EXPECT_TRUE(https_server_.Start());
   }
@@ -110,3 +159,71 @@ IN_PROC_BROWSER_TEST_F(SpeedReaderBrowserTest, P3ATest) {
   tester.ExpectBucketCount(kSpeedreaderToggleUMAHistogramName, 1, 1);
   tester.ExpectBucketCount(kSpeedreaderToggleUMAHistogramName, 2, 0);
 }
+
+// Each page below is sent to the renderer as it was received, and the loader
+// completes instead of hanging.
+class SpeedReaderLoaderBrowserTest
+    : public SpeedReaderBrowserTest,
+      public testing::WithParamInterface<bool> {
+ public:
+  SpeedReaderLoaderBrowserTest() {
+    if (GetParam()) {
+      streaming_feature_list_.InitAndEnableFeature(
+          speedreader::kSpeedreaderStreamingFeature);
+    } else {
+      streaming_feature_list_.InitAndDisableFeature(
+          speedreader::kSpeedreaderStreamingFeature);
+    }
+  }
+
+ protected:
+  content::RenderFrameHost* NavigateWithSpeedreader(const char* path) {
+    chrome::ExecuteCommand(browser(), IDC_TOGGLE_SPEEDREADER);
+    ui_test_utils::NavigateToURL(browser(),
+                                 https_server_.GetURL(kTestHost, path));
+    content::WebContents* contents =
+        browser()->tab_strip_model()->GetActiveWebContents();
+    return contents->GetMainFrame();
+  }
+
+  base::test::ScopedFeatureList streaming_feature_list_;
+};
+
+IN_PROC_BROWSER_TEST_P(SpeedReaderLoaderBrowserTest, ShortBody) {
+  base::HistogramTester tester;
+  content::RenderFrameHost* rfh = NavigateWithSpeedreader(kShortPage);
+
+  EXPECT_EQ(false, content::EvalJs(rfh, kHasSpeedreaderStyle));
+  EXPECT_EQ("Too short to distill",
+            content::EvalJs(rfh, "document.getElementById(\"short\")"
+                                 ".textContent"));
+  tester.ExpectTotalCount(kTimeToFirstByteUMAHistogramName, 1);
+}
+
+IN_PROC_BROWSER_TEST_P(SpeedReaderLoaderBrowserTest, DistillFailure) {
+  base::HistogramTester tester;
+  content::RenderFrameHost* rfh = NavigateWithSpeedreader(kDistillFailurePage);
+
+  EXPECT_EQ(false, content::EvalJs(rfh, kHasSpeedreaderStyle));
+  EXPECT_EQ(true,
+            content::EvalJs(rfh, "!!document.querySelector(\"select\")"));
+  EXPECT_EQ("Original",
+            content::EvalJs(rfh, "document.getElementById(\"original\")"
+                                 ".textContent"));
+  tester.ExpectTotalCount(kTimeToFirstByteUMAHistogramName, 1);
+}
+
+IN_PROC_BROWSER_TEST_P(SpeedReaderLoaderBrowserTest, AbortedBody) {
+  base::HistogramTester tester;
+  content::RenderFrameHost* rfh = NavigateWithSpeedreader(kAbortedPage);
+
+  EXPECT_EQ(false, content::EvalJs(rfh, kHasSpeedreaderStyle));
+  EXPECT_EQ("Partial",
+            content::EvalJs(rfh, "document.getElementById(\"partial\")"
+                                 ".textContent"));
+  tester.ExpectTotalCount(kTimeToFirstByteUMAHistogramName, 1);
+}
+
+INSTANTIATE_TEST_SUITE_P(Streaming,
+                         SpeedReaderLoaderBrowserTest,
+                         testing::Bool());
@@ -5,6 +5,9 @@
 
 #include "third_party/blink/renderer/core/execution_context/execution_context.h"
 
+#include <algorithm>
+#include <utility>
+
 #include "base/command_line.h"
 #include "base/strings/string_number_conversions.h"
 #include "brave/third_party/blink/renderer/brave_farbling_constants.h"
@@ -15,12 +18,15 @@
 #include "third_party/blink/renderer/core/frame/local_frame.h"
 #include "third_party/blink/renderer/core/workers/worker_global_scope.h"
 #include "third_party/blink/renderer/platform/bindings/script_state.h"
+#include "third_party/blink/renderer/platform/geometry/int_rect.h"
 #include "third_party/blink/renderer/platform/graphics/image_data_buffer.h"
 #include "third_party/blink/renderer/platform/graphics/static_bitmap_image.h"
 #include "third_party/blink/renderer/platform/graphics/unaccelerated_static_bitmap_image.h"
 #include "third_party/blink/renderer/platform/heap/handle.h"
 #include "third_party/blink/renderer/platform/network/network_utils.h"
 #include "third_party/blink/renderer/platform/supplementable.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "third_party/skia/include/core/SkImage.h"
 
 namespace {
 
@@ -30,25 +36,12 @@ inline uint64_t lfsr_next(uint64_t v) {
   return ((v >> 1) | (((v << 62) ^ (v << 61)) & (~(~zero << 63) << 62)));
 }
 
-float Identity(float value, size_t index) {
-  return value;
-}
-
-float ConstantMultiplier(double fudge_factor, float value, size_t index) {
-  return value * fudge_factor;
-}
+// The number of canvas contents whose perturbations are remembered
+const size_t kMaxCanvasPerturbations = 4;
 
-float PseudoRandomSequence(uint64_t seed, float value, size_t index) {
-  static uint64_t v;
+// Returns a pseudo-random float between 0 and 0.1 for a PRNG sequence value
+inline float PseudoRandomSample(uint64_t v) {
   const double maxUInt64AsDouble = UINT64_MAX;
-  if (index == 0) {
-    // start of loop, reset to initial seed which was passed in and is based on
-    // the domain key
-    v = seed;
-  }
-  // get next value in PRNG sequence
-  v = lfsr_next(v);
-  // return pseudo-random float between 0 and 0.1
   return (v / maxUInt64AsDouble) / 10;
 }
 
@@ -56,6 +49,67 @@ float PseudoRandomSequence(uint64_t seed, float value, size_t index) {
 
 namespace brave {
 
+AudioFarblingHelper::AudioFarblingHelper() = default;
+
+// static
+AudioFarblingHelper AudioFarblingHelper::CreateWithFudgeFactor(
+    double fudge_factor) {
+  AudioFarblingHelper helper;
+  helper.mode_ = Mode::kFudgeFactor;
+  helper.fudge_factor_ = fudge_factor;
+  return helper;
+}
+
+// static
+AudioFarblingHelper AudioFarblingHelper::CreateWithSeed(uint64_t seed) {
+  AudioFarblingHelper helper;
+  helper.mode_ = Mode::kPseudoRandom;
+  helper.seed_ = seed;
+  helper.sequence_state_ = seed;
+  return helper;
+}
+
+void AudioFarblingHelper::FarbleAudioChannel(float* samples,
+                                             size_t count) const {
+  switch (mode_) {
+    case Mode::kOff:
+      break;
+    case Mode::kFudgeFactor: {
+      // Kept free of branches and calls so that the compiler vectorizes it.
+      const double fudge_factor = fudge_factor_;
+      for (size_t i = 0; i < count; ++i)
+        samples[i] = samples[i] * fudge_factor;
+      break;
+    }
+    case Mode::kPseudoRandom: {
+      // The samples are replaced by pseudo-random data with no relation to the
+      // underlying audio, starting from the seed based on the domain key.
+      uint64_t v = seed_;
+      for (size_t i = 0; i < count; ++i) {
+        v = lfsr_next(v);
+        samples[i] = PseudoRandomSample(v);
+      }
+      break;
+    }
+  }
+}
+
+float AudioFarblingHelper::FarbleAudioSample(float value, size_t index) {
+  switch (mode_) {
+    case Mode::kOff:
+      return value;
+    case Mode::kFudgeFactor:
+      return value * fudge_factor_;
+    case Mode::kPseudoRandom:
+      if (index == 0)
+        sequence_state_ = seed_;
+      sequence_state_ = lfsr_next(sequence_state_);
+      return PseudoRandomSample(sequence_state_);
+  }
+  NOTREACHED();
+  return value;
+}
+
 const char kBraveSessionToken[] = "brave_session_token";
 const char BraveSessionCache::kSupplementName[] = "BraveSessionCache";
 
@@ -120,7 +174,7 @@ BraveSessionCache& BraveSessionCache::From(ExecutionContext& context) {
   return *cache;
 }
 
-AudioFarblingCallback BraveSessionCache::GetAudioFarblingCallback(
+AudioFarblingHelper BraveSessionCache::GetAudioFarblingHelper(
     blink::WebContentSettingsClient* settings) {
   if (farbling_enabled_ && settings) {
     switch (settings->GetBraveFarblingLevel()) {
@@ -133,15 +187,15 @@ AudioFarblingCallback BraveSessionCache::GetAudioFarblingCallback(
         double fudge_factor = 0.99 + ((*fudge / maxUInt64AsDouble) / 100);
         VLOG(1) << "audio fudge factor (based on session token) = "
                 << fudge_factor;
-        return base::BindRepeating(&ConstantMultiplier, fudge_factor);
+        return AudioFarblingHelper::CreateWithFudgeFactor(fudge_factor);
       }
       case BraveFarblingLevel::MAXIMUM: {
         uint64_t seed = *reinterpret_cast<uint64_t*>(domain_key_);
-        return base::BindRepeating(&PseudoRandomSequence, seed);
+        return AudioFarblingHelper::CreateWithSeed(seed);
       }
     }
   }
-  return base::BindRepeating(&Identity);
+  return AudioFarblingHelper();
 }
 
 scoped_refptr<blink::StaticBitmapImage> BraveSessionCache::PerturbPixels(
@@ -163,22 +217,63 @@ scoped_refptr<blink::StaticBitmapImage> BraveSessionCache::PerturbPixels(
   return image_bitmap;
 }
 
-scoped_refptr<blink::StaticBitmapImage>
-BraveSessionCache::PerturbPixelsInternal(
-    scoped_refptr<blink::StaticBitmapImage> image_bitmap) {
-  DCHECK(image_bitmap);
-  if (image_bitmap->IsNull())
+scoped_refptr<blink::StaticBitmapImage> BraveSessionCache::PerturbPixelsInRect(
+    blink::WebContentSettingsClient* settings,
+    scoped_refptr<blink::StaticBitmapImage> image_bitmap,
+    blink::IntRect* rect) {
+  if (!farbling_enabled_ || !settings)
     return image_bitmap;
+  switch (settings->GetBraveFarblingLevel()) {
+    case BraveFarblingLevel::OFF:
+      break;
+    case BraveFarblingLevel::BALANCED:
+    case BraveFarblingLevel::MAXIMUM: {
+      image_bitmap = PerturbPixelsInRectInternal(image_bitmap, rect);
+      break;
+    }
+    default:
+      NOTREACHED();
+  }
+  return image_bitmap;
+}
+
+BraveSessionCache::CanvasPerturbation::CanvasPerturbation() = default;
+
+BraveSessionCache::CanvasPerturbation::CanvasPerturbation(
+    CanvasPerturbation&& other) = default;
+
+BraveSessionCache::CanvasPerturbation&
+BraveSessionCache::CanvasPerturbation::operator=(CanvasPerturbation&& other) =
+    default;
+
+BraveSessionCache::CanvasPerturbation::~CanvasPerturbation() = default;
+
+BraveSessionCache::CanvasPerturbation& BraveSessionCache::GetCanvasPerturbation(
+    scoped_refptr<blink::StaticBitmapImage> image_bitmap,
+    std::unique_ptr<blink::ImageDataBuffer>* data_buffer) {
+  sk_sp<SkImage> sk_image =
+      image_bitmap->PaintImageForCurrentFrame().GetSkImage();
+  const uint32_t generation_id = sk_image ? sk_image->uniqueID() : 0;
+  auto it = std::find_if(canvas_perturbations_.begin(),
+                         canvas_perturbations_.end(),
+                         [generation_id](const CanvasPerturbation& entry) {
+                           return generation_id != 0 &&
+                                  entry.generation_id == generation_id;
+                         });
+  if (it != canvas_perturbations_.end()) {
+    std::rotate(canvas_perturbations_.begin(), it, it + 1);
+    return canvas_perturbations_.front();
+  }
+
   // convert to an ImageDataBuffer to normalize the pixel data to RGBA, 4 bytes
   // per pixel
-  std::unique_ptr<blink::ImageDataBuffer> data_buffer =
-      blink::ImageDataBuffer::Create(image_bitmap);
-  uint8_t* pixels = const_cast<uint8_t*>(data_buffer->Pixels());
+  *data_buffer = blink::ImageDataBuffer::Create(image_bitmap);
+  const uint8_t* pixels = (*data_buffer)->Pixels();
   // This needs to be type size_t because we pass it to base::StringPiece
   // later for content hashing. This is safe because the maximum canvas
   // dimensions are less than SIZE_T_MAX. (Width and height are each
   // limited to 32,767 pixels.)
-  const size_t pixel_count = data_buffer->Width() * data_buffer->Height();
+  const size_t pixel_count = (*data_buffer)->Width() * (*data_buffer)->Height();
   // choose which channel (R, G, or B) to perturb
   const uint8_t* first_byte = reinterpret_cast<const uint8_t*>(domain_key_);
   uint8_t channel = *first_byte % 3;
@@ -193,25 +288,99 @@ BraveSessionCache::PerturbPixelsInternal(
   CHECK(h.Sign(
       base::StringPiece(reinterpret_cast<const char*>(pixels), pixel_count),
       canvas_key, sizeof canvas_key));
+
+  CanvasPerturbation perturbation;
+  perturbation.generation_id = generation_id;
+  perturbation.info = (*data_buffer)->RetainedImage()->imageInfo();
   uint64_t v = *reinterpret_cast<uint64_t*>(canvas_key);
-  uint64_t pixel_index;
   // iterate through 32-byte canvas key and use each bit to determine how to
   // perturb the current pixel
   for (int i = 0; i < 32; i++) {
     uint8_t bit = canvas_key[i];
     for (int j = 8; j >= 0; j--) {
-      pixel_index = 4 * (v % pixel_count) + channel;
-      pixels[pixel_index] = pixels[pixel_index] ^ (bit & 0x1);
+      if (bit & 0x1)
+        perturbation.perturbed_bytes.push_back(4 * (v % pixel_count) + channel);
       bit = bit >> 1;
       // find next pixel to perturb
       v = lfsr_next(v);
     }
   }
+
+  canvas_perturbations_.insert(canvas_perturbations_.begin(),
+                               std::move(perturbation));
+  if (canvas_perturbations_.size() > kMaxCanvasPerturbations)
+    canvas_perturbations_.pop_back();
+  return canvas_perturbations_.front();
+}
+
+scoped_refptr<blink::StaticBitmapImage>
+BraveSessionCache::PerturbPixelsInternal(
+    scoped_refptr<blink::StaticBitmapImage> image_bitmap) {
+  DCHECK(image_bitmap);
+  if (image_bitmap->IsNull())
+    return image_bitmap;
+  std::unique_ptr<blink::ImageDataBuffer> data_buffer;
+  const CanvasPerturbation& perturbation =
+      GetCanvasPerturbation(image_bitmap, &data_buffer);
+  // the canvas hasn't changed since it was last perturbed, so only the
+  // readback is needed
+  if (!data_buffer)
+    data_buffer = blink::ImageDataBuffer::Create(image_bitmap);
+  uint8_t* pixels = const_cast<uint8_t*>(data_buffer->Pixels());
+  for (const size_t offset : perturbation.perturbed_bytes)
+    pixels[offset] = pixels[offset] ^ 0x1;
   // convert back to a StaticBitmapImage to return to the caller
-  scoped_refptr<blink::StaticBitmapImage> perturbed_bitmap =
-      blink::UnacceleratedStaticBitmapImage::Create(
-          data_buffer->RetainedImage());
-  return perturbed_bitmap;
+  return blink::UnacceleratedStaticBitmapImage::Create(
+      data_buffer->RetainedImage());
+}
+
+scoped_refptr<blink::StaticBitmapImage>
+BraveSessionCache::PerturbPixelsInRectInternal(
+    scoped_refptr<blink::StaticBitmapImage> image_bitmap,
+    blink::IntRect* rect) {
+  DCHECK(image_bitmap);
+  DCHECK(rect);
+  if (image_bitmap->IsNull())
+    return image_bitmap;
+  blink::IntRect region = *rect;
+  region.Intersect(blink::IntRect(blink::IntPoint(), image_bitmap->Size()));
+  // nothing is read from the canvas
+  if (region.IsEmpty())
+    return image_bitmap;
+  if (region.Size() == image_bitmap->Size())
+    return PerturbPixelsInternal(image_bitmap);
+
+  std::unique_ptr<blink::ImageDataBuffer> data_buffer;
+  const CanvasPerturbation& perturbation =
+      GetCanvasPerturbation(image_bitmap, &data_buffer);
+
+  // read back only the region, in the same layout the perturbation was
+  // computed in
+  sk_sp<SkImage> sk_image =
+      data_buffer ? data_buffer->RetainedImage()
+                  : image_bitmap->PaintImageForCurrentFrame().GetSkImage();
+  SkBitmap bitmap;
+  if (!sk_image ||
+      !bitmap.tryAllocPixels(
+          perturbation.info.makeWH(region.Width(), region.Height())) ||
+      !sk_image->readPixels(bitmap.pixmap(), region.X(), region.Y())) {
+    return PerturbPixelsInternal(image_bitmap);
+  }
+  uint8_t* pixels = static_cast<uint8_t*>(bitmap.getPixels());
+  const size_t width = perturbation.info.width();
+  for (const size_t offset : perturbation.perturbed_bytes) {
+    const size_t pixel = offset / 4;
+    const int x = static_cast<int>(pixel % width) - region.X();
+    const int y = static_cast<int>(pixel / width) - region.Y();
+    if (x < 0 || y < 0 || x >= region.Width() || y >= region.Height())
+      continue;
+    const size_t region_offset = bitmap.rowBytes() * y + 4 * x + offset % 4;
+    pixels[region_offset] = pixels[region_offset] ^ 0x1;
+  }
+  bitmap.setImmutable();
+  rect->Move(-region.X(), -region.Y());
+  return blink::UnacceleratedStaticBitmapImage::Create(
+      SkImage::MakeFromBitmap(bitmap));
 }
 
 WTF::String BraveSessionCache::GenerateRandomString(std::string seed,
@@ -8,11 +8,15 @@
 
 #include "../../../../../../../third_party/blink/renderer/core/execution_context/execution_context.h"
 
+#include <memory>
 #include <random>
+#include <vector>
 
-#include "base/callback.h"
+#include "third_party/skia/include/core/SkImageInfo.h"
 
 namespace blink {
+class ImageDataBuffer;
+class IntRect;
 class StaticBitmapImage;
 class WebContentSettingsClient;
 }  // namespace blink
@@ -27,7 +31,36 @@ using blink::TraceTrait;
 
 namespace brave {
 
-typedef base::RepeatingCallback<float(float, size_t)> AudioFarblingCallback;
+// Farbles audio samples a block at a time rather than through a callback per
+// sample. The pseudo-random sequence state lives on the stack or in the
+// helper, never in a static, so helpers can be used from any audio thread.
+class CORE_EXPORT AudioFarblingHelper {
+ public:
+  // Leaves samples untouched.
+  AudioFarblingHelper();
+
+  static AudioFarblingHelper CreateWithFudgeFactor(double fudge_factor);
+  static AudioFarblingHelper CreateWithSeed(uint64_t seed);
+
+  bool IsEnabled() const { return mode_ != Mode::kOff; }
+
+  // Farbles |count| samples in place. The pseudo-random sequence restarts
+  // from its seed on every call.
+  void FarbleAudioChannel(float* samples, size_t count) const;
+
+  // Farbles sample |index| of a loop which can't farble a whole block, e.g.
+  // one converting samples to bytes. The pseudo-random sequence restarts from
+  // its seed at index 0.
+  float FarbleAudioSample(float value, size_t index);
+
+ private:
+  enum class Mode { kOff, kFudgeFactor, kPseudoRandom };
+
+  Mode mode_ = Mode::kOff;
+  double fudge_factor_ = 1.0;
+  uint64_t seed_ = 0;
+  uint64_t sequence_state_ = 0;
+};
 
 CORE_EXPORT blink::WebContentSettingsClient* GetContentSettingsClientFor(
     ExecutionContext* context);
@@ -43,21 +76,56 @@ class CORE_EXPORT BraveSessionCache final
 
   static BraveSessionCache& From(ExecutionContext&);
 
-  AudioFarblingCallback GetAudioFarblingCallback(
+  AudioFarblingHelper GetAudioFarblingHelper(
       blink::WebContentSettingsClient* settings);
   scoped_refptr<blink::StaticBitmapImage> PerturbPixels(
       blink::WebContentSettingsClient* settings,
       scoped_refptr<blink::StaticBitmapImage> image_bitmap);
+  // Perturbs pixels for a read of |rect| only, e.g. by getImageData(). The
+  // returned image may hold just the part of the canvas inside |rect|, in
+  // which case |rect| is moved to be relative to it.
+  scoped_refptr<blink::StaticBitmapImage> PerturbPixelsInRect(
+      blink::WebContentSettingsClient* settings,
+      scoped_refptr<blink::StaticBitmapImage> image_bitmap,
+      blink::IntRect* rect);
   WTF::String GenerateRandomString(std::string seed, wtf_size_t length);
   std::mt19937_64 MakePseudoRandomGenerator();
 
  private:
+  // The pixels perturbed for one generation of a canvas' contents, so reading
+  // an unchanged canvas again doesn't need a new HMAC. The perturbed image
+  // itself isn't kept, as it is as large as the canvas.
+  struct CanvasPerturbation {
+    CanvasPerturbation();
+    CanvasPerturbation(CanvasPerturbation&& other);
+    CanvasPerturbation& operator=(CanvasPerturbation&& other);
+    ~CanvasPerturbation();
+
+    // The unique ID of the canvas snapshot, which Skia keeps for as long as
+    // the canvas isn't drawn to. 0 is never matched.
+    uint32_t generation_id = 0;
+    SkImageInfo info;
+    // Offsets of the bytes whose lowest bit is flipped, 4 bytes per pixel.
+    std::vector<size_t> perturbed_bytes;
+  };
+
   bool farbling_enabled_;
   uint64_t session_key_;
   uint8_t domain_key_[32];
-
+  // Most recently used first.
+  std::vector<CanvasPerturbation> canvas_perturbations_;
+
+  // Returns the perturbation for |image_bitmap|, computing it if it isn't
+  // cached. |data_buffer| is set to the full readback of |image_bitmap| only
+  // if one was needed.
+  CanvasPerturbation& GetCanvasPerturbation(
+      scoped_refptr<blink::StaticBitmapImage> image_bitmap,
+      std::unique_ptr<blink::ImageDataBuffer>* data_buffer);
   scoped_refptr<blink::StaticBitmapImage> PerturbPixelsInternal(
       scoped_refptr<blink::StaticBitmapImage> image_bitmap);
+  scoped_refptr<blink::StaticBitmapImage> PerturbPixelsInRectInternal(
+      scoped_refptr<blink::StaticBitmapImage> image_bitmap,
+      blink::IntRect* rect);
 };
 }  // namespace brave
 
@@ -12,13 +12,13 @@
 #include "third_party/blink/renderer/core/frame/local_frame.h"
 #include "third_party/blink/renderer/core/workers/worker_global_scope.h"
 
-#define BRAVE_GET_IMAGE_DATA                                              \
-  if (ExecutionContext* context = ExecutionContext::From(script_state)) { \
-    if (WebContentSettingsClient* settings =                              \
-            brave::GetContentSettingsClientFor(context)) {                \
-      snapshot = brave::BraveSessionCache::From(*context).PerturbPixels(  \
-          settings, snapshot);                                            \
-    }                                                                     \
+#define BRAVE_GET_IMAGE_DATA                                                   \
+  if (ExecutionContext* context = ExecutionContext::From(script_state)) {      \
+    if (WebContentSettingsClient* settings =                                   \
+            brave::GetContentSettingsClientFor(context)) {                     \
+      snapshot = brave::BraveSessionCache::From(*context).PerturbPixelsInRect( \
+          settings, snapshot, &image_data_rect);                               \
+    }                                                                          \
   }
 
 #define BRAVE_GET_IMAGE_DATA_PARAMS ScriptState *script_state,
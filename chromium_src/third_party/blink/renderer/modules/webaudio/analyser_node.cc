@@ -12,14 +12,14 @@
 #include "third_party/blink/renderer/core/frame/local_frame.h"
 #include "third_party/blink/renderer/core/workers/worker_global_scope.h"
 
-#define BRAVE_ANALYSERHANDLER_CONSTRUCTOR                                    \
-  if (ExecutionContext* context = node.GetExecutionContext()) {              \
-    if (WebContentSettingsClient* settings =                                 \
-            brave::GetContentSettingsClientFor(context)) {                   \
-      analyser_.audio_farbling_callback_ =                                   \
-          brave::BraveSessionCache::From(*context).GetAudioFarblingCallback( \
-              settings);                                                     \
-    }                                                                        \
+#define BRAVE_ANALYSERHANDLER_CONSTRUCTOR                                  \
+  if (ExecutionContext* context = node.GetExecutionContext()) {            \
+    if (WebContentSettingsClient* settings =                               \
+            brave::GetContentSettingsClientFor(context)) {                 \
+      analyser_.audio_farbling_helper_ =                                   \
+          brave::BraveSessionCache::From(*context).GetAudioFarblingHelper( \
+              settings);                                                   \
+    }                                                                      \
   }
 
 #include "../../../../../../../third_party/blink/renderer/modules/webaudio/analyser_node.cc"
@@ -0,0 +1,62 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/common/host_matcher.h"
+
+#include <algorithm>
+
+#include "base/strings/string_util.h"
+
+namespace brave {
+
+namespace {
+
+const char kAnyHost[] = "*";
+
+}  // namespace
+
+HostMatcher::HostMatcher() = default;
+
+HostMatcher::~HostMatcher() = default;
+
+void HostMatcher::Add(base::StringPiece domain, size_t id) {
+  if (domain == kAnyHost) {
+    any_host_id_ = any_host_id_ ? std::min(*any_host_id_, id) : id;
+    return;
+  }
+
+  if (base::StartsWith(domain, "*.", base::CompareCase::SENSITIVE))
+    domain.remove_prefix(2);
+  if (domain.empty())
+    return;
+
+  auto result = ids_.emplace(base::ToLowerASCII(domain), id);
+  if (!result.second)
+    result.first->second = std::min(result.first->second, id);
+}
+
+bool HostMatcher::Match(base::StringPiece host, size_t* id) const {
+  bool matched = false;
+  if (any_host_id_ && !host.empty()) {
+    *id = *any_host_id_;
+    matched = true;
+  }
+
+  while (!host.empty()) {
+    auto it = ids_.find(host);
+    if (it != ids_.end() && (!matched || it->second < *id)) {
+      *id = it->second;
+      matched = true;
+    }
+
+    const size_t pos = host.find('.');
+    if (pos == base::StringPiece::npos)
+      break;
+    host.remove_prefix(pos + 1);
+  }
+  return matched;
+}
+
+}  // namespace brave
@@ -0,0 +1,48 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMMON_HOST_MATCHER_H_
+#define BRAVE_COMMON_HOST_MATCHER_H_
+
+#include <functional>
+#include <map>
+#include <string>
+
+#include "base/macros.h"
+#include "base/optional.h"
+#include "base/strings/string_piece.h"
+
+namespace brave {
+
+// A set of domains which matches a host against all of them, including their
+// subdomains, by looking up the host and each of its parent domains rather
+// than by testing every domain. Build it once and share it between requests.
+class HostMatcher {
+ public:
+  HostMatcher();
+  ~HostMatcher();
+
+  // Adds |domain| so that it and its subdomains match with |id|. A leading
+  // "*." is ignored, and "*" matches every host.
+  void Add(base::StringPiece domain, size_t id);
+
+  // Returns true if |host| is one of the added domains or a subdomain of one,
+  // setting |id| to the lowest id of the matching domains.
+  bool Match(base::StringPiece host, size_t* id) const;
+
+  bool empty() const { return ids_.empty() && !any_host_id_; }
+  size_t size() const { return ids_.size() + (any_host_id_ ? 1 : 0); }
+
+ private:
+  std::map<std::string, size_t, std::less<>> ids_;
+  // The lowest id added with "*", if any.
+  base::Optional<size_t> any_host_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(HostMatcher);
+};
+
+}  // namespace brave
+
+#endif  // BRAVE_COMMON_HOST_MATCHER_H_
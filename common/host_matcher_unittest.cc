@@ -0,0 +1,134 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/common/host_matcher.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/timer/elapsed_timer.h"
+#include "brave/common/shield_exceptions.h"
+#include "extensions/common/url_pattern.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "url/gurl.h"
+
+namespace brave {
+
+TEST(HostMatcherTest, MatchDomainsAndSubdomains) {
+  HostMatcher matcher;
+  matcher.Add("brave.com", 0);
+  matcher.Add("*.Example.com", 1);
+
+  size_t id = 42;
+  EXPECT_TRUE(matcher.Match("brave.com", &id));
+  EXPECT_EQ(0u, id);
+  EXPECT_TRUE(matcher.Match("www.search.brave.com", &id));
+  EXPECT_EQ(0u, id);
+  EXPECT_TRUE(matcher.Match("example.com", &id));
+  EXPECT_EQ(1u, id);
+
+  EXPECT_FALSE(matcher.Match("notbrave.com", &id));
+  EXPECT_FALSE(matcher.Match("brave.com.evil", &id));
+  EXPECT_FALSE(matcher.Match("com", &id));
+  EXPECT_FALSE(matcher.Match("", &id));
+}
+
+TEST(HostMatcherTest, MatchLowestId) {
+  HostMatcher matcher;
+  matcher.Add("search.brave.com", 0);
+  matcher.Add("brave.com", 1);
+  matcher.Add("search.brave.com", 2);
+
+  size_t id;
+  EXPECT_TRUE(matcher.Match("www.search.brave.com", &id));
+  EXPECT_EQ(0u, id);
+  EXPECT_TRUE(matcher.Match("www.brave.com", &id));
+  EXPECT_EQ(1u, id);
+  EXPECT_EQ(2u, matcher.size());
+}
+
+TEST(HostMatcherTest, MatchAnyHost) {
+  HostMatcher matcher;
+  matcher.Add("brave.com", 0);
+  matcher.Add("*", 1);
+
+  size_t id;
+  EXPECT_TRUE(matcher.Match("brave.com", &id));
+  EXPECT_EQ(0u, id);
+  EXPECT_TRUE(matcher.Match("example.com", &id));
+  EXPECT_EQ(1u, id);
+  EXPECT_TRUE(matcher.Match("localhost", &id));
+  EXPECT_EQ(1u, id);
+  EXPECT_FALSE(matcher.Match("", &id));
+  EXPECT_EQ(2u, matcher.size());
+}
+
+TEST(HostMatcherTest, IsUAWhitelisted) {
+  EXPECT_TRUE(IsUAWhitelisted(GURL("https://duckduckgo.com/?q=brave")));
+  EXPECT_TRUE(IsUAWhitelisted(GURL("https://www.netflix.com/")));
+  EXPECT_FALSE(IsUAWhitelisted(GURL("http://www.netflix.com/")));
+  EXPECT_FALSE(IsUAWhitelisted(GURL("https://netflix.com.evil/")));
+  EXPECT_FALSE(IsUAWhitelisted(GURL("https://brave.com/")));
+}
+
+// Disabled by default, as it is a benchmark. Run it with
+// --gtest_also_run_disabled_tests.
+TEST(HostMatcherTest, DISABLED_MatchThousandDomainsBenchmark) {
+  const size_t kDomainCount = 1000;
+
+  std::vector<URLPattern> patterns;
+  HostMatcher matcher;
+  for (size_t i = 0; i < kDomainCount; ++i) {
+    const std::string domain = "domain" + base::NumberToString(i) + ".com";
+    URLPattern pattern(URLPattern::SCHEME_HTTPS | URLPattern::SCHEME_HTTP);
+    pattern.SetScheme("*");
+    pattern.SetHost(domain);
+    pattern.SetPath("/*");
+    pattern.SetMatchSubdomains(true);
+    patterns.push_back(pattern);
+    matcher.Add(domain, i);
+  }
+
+  std::vector<GURL> urls;
+  for (size_t i = 0; i < kDomainCount; ++i) {
+    urls.push_back(GURL("https://cdn.domain" + base::NumberToString(i) +
+                        ".com/script.js"));
+    urls.push_back(GURL("https://cdn.other" + base::NumberToString(i) +
+                        ".com/script.js"));
+  }
+
+  base::ElapsedTimer patterns_timer;
+  size_t patterns_matches = 0;
+  for (const auto& url : urls) {
+    if (std::any_of(patterns.begin(), patterns.end(),
+                    [&url](const URLPattern& pattern) {
+                      return pattern.MatchesURL(url);
+                    })) {
+      patterns_matches++;
+    }
+  }
+  const base::TimeDelta patterns_elapsed = patterns_timer.Elapsed();
+
+  base::ElapsedTimer matcher_timer;
+  size_t matcher_matches = 0;
+  for (const auto& url : urls) {
+    size_t id;
+    if (matcher.Match(url.host_piece(), &id))
+      matcher_matches++;
+  }
+  const base::TimeDelta matcher_elapsed = matcher_timer.Elapsed();
+
+  EXPECT_EQ(kDomainCount, patterns_matches);
+  EXPECT_EQ(patterns_matches, matcher_matches);
+  LOG(INFO) << "Matched " << urls.size() << " hosts against " << kDomainCount
+            << " domains in " << matcher_elapsed.InMicroseconds()
+            << "us using the matcher (" << patterns_elapsed.InMicroseconds()
+            << "us testing every pattern)";
+}
+
+}  // namespace brave
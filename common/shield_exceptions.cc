@@ -5,24 +5,23 @@
 
 #include "brave/common/shield_exceptions.h"
 
-#include <algorithm>
-#include <vector>
-
-#include "extensions/common/url_pattern.h"
+#include "brave/common/host_matcher.h"
 #include "url/gurl.h"
+#include "url/url_constants.h"
 
 namespace brave {
 
 bool IsUAWhitelisted(const GURL& gurl) {
-  static std::vector<URLPattern> whitelist_patterns({
-    URLPattern(URLPattern::SCHEME_ALL, "https://*.duckduckgo.com/*"),
+  static const HostMatcher* const whitelist = [] {
+    HostMatcher* matcher = new HostMatcher();
+    matcher->Add("duckduckgo.com", 0);
     // For Widevine
-    URLPattern(URLPattern::SCHEME_ALL, "https://*.netflix.com/*")
-  });
-  return std::any_of(whitelist_patterns.begin(), whitelist_patterns.end(),
-      [&gurl](URLPattern pattern){
-        return pattern.MatchesURL(gurl);
-      });
+    matcher->Add("netflix.com", 0);
+    return matcher;
+  }();
+  size_t id;
+  return gurl.SchemeIs(url::kHttpsScheme) &&
+         whitelist->Match(gurl.host_piece(), &id);
 }
 
 }  // namespace brave
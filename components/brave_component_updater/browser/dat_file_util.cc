@@ -6,32 +6,46 @@
 #include "brave/components/brave_component_updater/browser/dat_file_util.h"
 
 #include <string>
+#include <utility>
 
 #include "base/logging.h"
+#include "base/files/file.h"
 #include "base/files/file_path.h"
 #include "base/files/file_util.h"
+#include "base/task/post_task.h"
 
 namespace brave_component_updater {
 
-void GetDATFileData(const base::FilePath& file_path,
-                    DATFileDataBuffer* buffer) {
-  int64_t size = 0;
-  if (!base::PathExists(file_path) ||
-      !base::GetFileSize(file_path, &size) ||
-      0 == size) {
-    LOG(ERROR) << "GetDATFileData: "
+std::unique_ptr<DATFileMapping> MapDATFile(const base::FilePath& file_path) {
+  // Share delete access so that the component updater can still remove old
+  // versions while a consumer holds on to the mapping.
+  base::File file(file_path, base::File::FLAG_OPEN | base::File::FLAG_READ |
+                                 base::File::FLAG_SHARE_DELETE);
+  if (!file.IsValid() || file.GetLength() <= 0) {
+    LOG(ERROR) << "MapDATFile: "
                << "the dat file is not found or corrupted "
                << file_path;
-    return;
+    return nullptr;
   }
 
-  buffer->resize(size);
-  if (size != base::ReadFile(file_path,
-                             reinterpret_cast<char*>(&buffer->front()),
-                             size)) {
-    LOG(ERROR) << "GetDATFileData: cannot "
-               << "read dat file " << file_path;
+  auto mapping = std::make_unique<DATFileMapping>();
+  if (!mapping->Initialize(std::move(file))) {
+    LOG(ERROR) << "MapDATFile: cannot "
+               << "map dat file " << file_path;
+    return nullptr;
   }
+
+  return mapping;
+}
+
+void ReleaseDATFileMapping(std::unique_ptr<DATFileMapping> mapping) {
+  if (!mapping)
+    return;
+
+  base::DeleteSoon(FROM_HERE,
+                   {base::ThreadPool(), base::MayBlock(),
+                    base::TaskPriority::BEST_EFFORT},
+                   std::move(mapping));
 }
 
 std::string GetDATFileAsString(const base::FilePath& file_path) {
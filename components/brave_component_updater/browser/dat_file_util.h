@@ -9,38 +9,66 @@
 #include <memory>
 #include <string>
 #include <utility>
-#include <vector>
 
 #include "base/files/file_path.h"
+#include "base/files/memory_mapped_file.h"
 
 namespace brave_component_updater {
 
-using DATFileDataBuffer = std::vector<unsigned char>;
+// Read-only mapping of a DAT file. Its pages are backed by the file rather
+// than by the heap, so the OS can drop them from memory when not in use.
+using DATFileMapping = base::MemoryMappedFile;
 
-void GetDATFileData(const base::FilePath& file_path,
-                    DATFileDataBuffer* buffer);
+// Returns nullptr if the file is not found, empty or cannot be mapped.
+std::unique_ptr<DATFileMapping> MapDATFile(const base::FilePath& file_path);
+// Unmapping closes the file, which may block, so mappings held on the UI
+// thread are released on the thread pool instead.
+void ReleaseDATFileMapping(std::unique_ptr<DATFileMapping> mapping);
 std::string GetDATFileAsString(const base::FilePath& file_path);
 
 template<typename T>
-using LoadDATFileDataResult =
-    std::pair<std::unique_ptr<T>, brave_component_updater::DATFileDataBuffer>;
+bool DeserializeDATFileData(DATFileMapping* mapping, T* client) {
+  // Deserializers only read from the data, which is mapped read-only.
+  return client->deserialize(reinterpret_cast<char*>(mapping->data()),
+                             mapping->length());
+}
 
+// Deserializes a T straight from the mapped DAT file and unmaps it once
+// deserialization finishes. Returns nullptr on failure.
 template<typename T>
-LoadDATFileDataResult<T> LoadDATFileData(
-    const base::FilePath& dat_file_path) {
-  DATFileDataBuffer buffer;
-  GetDATFileData(dat_file_path, &buffer);
-  std::unique_ptr<T> client;
-  client = std::make_unique<T>();
-  if (buffer.empty() ||
-      !client->deserialize(reinterpret_cast<char*>(&buffer.front()),
-          buffer.size()))
+std::unique_ptr<T> LoadDATFileData(const base::FilePath& dat_file_path) {
+  std::unique_ptr<DATFileMapping> mapping = MapDATFile(dat_file_path);
+  if (!mapping)
+    return nullptr;
+
+  auto client = std::make_unique<T>();
+  if (!DeserializeDATFileData(mapping.get(), client.get()))
     client.reset();
 
-  return LoadDATFileDataResult<T>(
-      std::move(client), std::move(buffer));
+  return client;
 }
 
+template<typename T>
+using LoadMappedDATFileDataResult =
+    std::pair<std::unique_ptr<T>, std::unique_ptr<DATFileMapping>>;
+
+// Like LoadDATFileData, but hands the mapping back with the deserialized T
+// for consumers that refer into the DAT data or deserialize it again later.
+// The mapping is null if the file could not be mapped.
+template<typename T>
+LoadMappedDATFileDataResult<T> LoadMappedDATFileData(
+    const base::FilePath& dat_file_path) {
+  std::unique_ptr<DATFileMapping> mapping = MapDATFile(dat_file_path);
+  std::unique_ptr<T> client;
+  if (mapping) {
+    client = std::make_unique<T>();
+    if (!DeserializeDATFileData(mapping.get(), client.get()))
+      client.reset();
+  }
+
+  return LoadMappedDATFileDataResult<T>(
+      std::move(client), std::move(mapping));
+}
 
 }  // namespace brave_component_updater
 
@@ -0,0 +1,170 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_component_updater/browser/dat_file_util.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/logging.h"
+#include "base/path_service.h"
+#include "base/process/process_metrics.h"
+#include "base/test/task_environment.h"
+#include "base/timer/elapsed_timer.h"
+#include "brave/common/brave_paths.h"
+#include "brave/vendor/adblock_rust_ffi/src/wrapper.hpp"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace brave_component_updater {
+
+namespace {
+
+// Stands in for the DAT consumers, which copy what they need out of the
+// serialized data.
+class TestDATParser {
+ public:
+  bool deserialize(const char* data, size_t data_size) {
+    if (data_size < 4 || std::string(data, 4) != "DAT1")
+      return false;
+
+    checksum_ = 0;
+    for (size_t i = 0; i < data_size; ++i)
+      checksum_ += static_cast<unsigned char>(data[i]);
+    return true;
+  }
+
+  uint64_t checksum() const { return checksum_; }
+
+ private:
+  uint64_t checksum_ = 0;
+};
+
+}  // namespace
+
+class DATFileUtilTest : public testing::Test {
+ protected:
+  void SetUp() override { ASSERT_TRUE(temp_dir_.CreateUniqueTempDir()); }
+
+  base::FilePath WriteDATFile(const std::string& name,
+                              const std::string& contents) {
+    base::FilePath path = temp_dir_.GetPath().AppendASCII(name);
+    EXPECT_EQ(static_cast<int>(contents.size()),
+              base::WriteFile(path, contents.data(), contents.size()));
+    return path;
+  }
+
+  base::test::TaskEnvironment task_environment_;
+  base::ScopedTempDir temp_dir_;
+};
+
+TEST_F(DATFileUtilTest, LoadDATFileData) {
+  auto parser =
+      LoadDATFileData<TestDATParser>(WriteDATFile("test.dat", "DAT1\x01\x02"));
+  ASSERT_TRUE(parser);
+  EXPECT_EQ(static_cast<uint64_t>('D' + 'A' + 'T' + '1' + 1 + 2),
+            parser->checksum());
+}
+
+TEST_F(DATFileUtilTest, LoadDATFileDataFailures) {
+  EXPECT_FALSE(LoadDATFileData<TestDATParser>(
+      temp_dir_.GetPath().AppendASCII("missing.dat")));
+  EXPECT_FALSE(LoadDATFileData<TestDATParser>(WriteDATFile("empty.dat", "")));
+  EXPECT_FALSE(
+      LoadDATFileData<TestDATParser>(WriteDATFile("invalid.dat", "DAT2")));
+}
+
+TEST_F(DATFileUtilTest, LoadMappedDATFileData) {
+  auto result = LoadMappedDATFileData<TestDATParser>(
+      WriteDATFile("test.dat", "DAT1\x01\x02"));
+  ASSERT_TRUE(result.first);
+  ASSERT_TRUE(result.second);
+  EXPECT_EQ(6u, result.second->length());
+
+  // A kept mapping can be deserialized again, e.g. to rebuild an engine.
+  TestDATParser parser;
+  EXPECT_TRUE(DeserializeDATFileData(result.second.get(), &parser));
+  EXPECT_EQ(result.first->checksum(), parser.checksum());
+
+  ReleaseDATFileMapping(std::move(result.second));
+  task_environment_.RunUntilIdle();
+}
+
+TEST_F(DATFileUtilTest, LoadMappedDATFileDataFailures) {
+  auto missing = LoadMappedDATFileData<TestDATParser>(
+      temp_dir_.GetPath().AppendASCII("missing.dat"));
+  EXPECT_FALSE(missing.first);
+  EXPECT_FALSE(missing.second);
+
+  // The mapping is returned so that callers can tell a corrupted file from a
+  // missing one.
+  auto invalid =
+      LoadMappedDATFileData<TestDATParser>(WriteDATFile("invalid.dat", "DAT2"));
+  EXPECT_FALSE(invalid.first);
+  EXPECT_TRUE(invalid.second);
+}
+
+// Loads the real default ad block DAT both ways and reports how much the
+// process' malloc heap grew while the engine and the data it was loaded from
+// were held. Private heap growth is what a mapping saves; the mapped pages
+// are clean and file-backed, so they are not counted. The extension whitelist
+// and Speedreader DATs are not part of the test data, so they are not
+// measured here.
+//
+// Disabled by default, as it is a benchmark. Run it with
+// --gtest_also_run_disabled_tests.
+TEST_F(DATFileUtilTest, DISABLED_RetainedMemoryBenchmark) {
+  base::FilePath test_data_dir;
+  ASSERT_TRUE(base::PathService::Get(brave::DIR_TEST_DATA, &test_data_dir));
+  const base::FilePath path = test_data_dir.AppendASCII("adblock-data")
+                                  .AppendASCII("adblock-default")
+                                  .AppendASCII("rs-ABPFilterParserData.dat");
+  std::unique_ptr<base::ProcessMetrics> metrics =
+      base::ProcessMetrics::CreateCurrentProcessMetrics();
+
+  // Previously the whole file was read into a heap buffer, which the ad
+  // block service held on to next to the engine.
+  size_t malloc_usage = metrics->GetMallocUsage();
+  base::ElapsedTimer buffer_timer;
+  int64_t file_size = 0;
+  ASSERT_TRUE(base::GetFileSize(path, &file_size));
+  std::vector<unsigned char> buffer(file_size);
+  ASSERT_EQ(static_cast<int>(buffer.size()),
+            base::ReadFile(path, reinterpret_cast<char*>(buffer.data()),
+                           buffer.size()));
+  auto buffer_engine = std::make_unique<adblock::Engine>();
+  ASSERT_TRUE(buffer_engine->deserialize(
+      reinterpret_cast<char*>(buffer.data()), buffer.size()));
+  const base::TimeDelta buffer_elapsed = buffer_timer.Elapsed();
+  const int64_t buffer_retained =
+      static_cast<int64_t>(metrics->GetMallocUsage()) -
+      static_cast<int64_t>(malloc_usage);
+  buffer_engine.reset();
+  std::vector<unsigned char>().swap(buffer);
+
+  malloc_usage = metrics->GetMallocUsage();
+  base::ElapsedTimer mapping_timer;
+  auto result = LoadMappedDATFileData<adblock::Engine>(path);
+  ASSERT_TRUE(result.first);
+  const base::TimeDelta mapping_elapsed = mapping_timer.Elapsed();
+  const int64_t mapping_retained =
+      static_cast<int64_t>(metrics->GetMallocUsage()) -
+      static_cast<int64_t>(malloc_usage);
+
+  LOG(INFO) << "ad block (" << file_size << " byte DAT): malloc heap grew "
+            << buffer_retained << " bytes buffered vs " << mapping_retained
+            << " bytes mapped; load took " << buffer_elapsed.InMicroseconds()
+            << "us buffered vs " << mapping_elapsed.InMicroseconds()
+            << "us mapped";
+
+  result.first.reset();
+  ReleaseDATFileMapping(std::move(result.second));
+  task_environment_.RunUntilIdle();
+}
+
+}  // namespace brave_component_updater
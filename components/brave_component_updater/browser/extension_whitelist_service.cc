@@ -30,6 +30,7 @@ ExtensionWhitelistService::ExtensionWhitelistService(
 ExtensionWhitelistService::~ExtensionWhitelistService() {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
   extension_whitelist_client_.reset();
+  ReleaseDATFileMapping(std::move(dat_file_mapping_));
 }
 
 bool ExtensionWhitelistService::IsWhitelisted(
@@ -69,7 +70,8 @@ void ExtensionWhitelistService::OnComponentReady(
       local_data_files_service()->GetTaskRunner().get(),
       FROM_HERE,
       base::BindOnce(
-          &brave_component_updater::LoadDATFileData<ExtensionWhitelistParser>,
+          &brave_component_updater::LoadMappedDATFileData<
+              ExtensionWhitelistParser>,
           dat_file_path),
       base::BindOnce(&ExtensionWhitelistService::OnGetDATFileData,
                      weak_factory_.GetWeakPtr()));
@@ -77,17 +79,19 @@ void ExtensionWhitelistService::OnComponentReady(
 
 void ExtensionWhitelistService::OnGetDATFileData(GetDATFileDataResult result) {
   DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
-  if (result.second.empty()) {
+  if (!result.second) {
     LOG(ERROR) << "Could not obtain extension whitelist data";
     return;
   }
   if (!result.first.get()) {
     LOG(ERROR) << "Failed to deserialize extension whitelist data";
+    ReleaseDATFileMapping(std::move(result.second));
     return;
   }
 
   extension_whitelist_client_ = std::move(result.first);
-  buffer_ = std::move(result.second);
+  ReleaseDATFileMapping(std::move(dat_file_mapping_));
+  dat_file_mapping_ = std::move(result.second);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -32,7 +32,8 @@ namespace brave_component_updater {
 class ExtensionWhitelistService : public LocalDataFilesObserver {
  public:
   using GetDATFileDataResult =
-      brave_component_updater::LoadDATFileDataResult<ExtensionWhitelistParser>;
+      brave_component_updater::LoadMappedDATFileDataResult<
+          ExtensionWhitelistParser>;
 
   explicit ExtensionWhitelistService(
       LocalDataFilesService* local_data_files_service,
@@ -57,7 +58,8 @@ class ExtensionWhitelistService : public LocalDataFilesObserver {
 
   SEQUENCE_CHECKER(sequence_checker_);
   std::unique_ptr<ExtensionWhitelistParser> extension_whitelist_client_;
-  brave_component_updater::DATFileDataBuffer buffer_;
+  // The whitelist refers into the DAT data, so the mapping is kept alive.
+  std::unique_ptr<brave_component_updater::DATFileMapping> dat_file_mapping_;
   std::vector<std::string> whitelist_;
   base::WeakPtrFactory<ExtensionWhitelistService> weak_factory_;
 
@@ -14,6 +14,7 @@
 #include "base/files/file_util.h"
 #include "base/json/json_reader.h"
 #include "base/json/json_writer.h"
+#include "base/optional.h"
 #include "base/path_service.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/string_util.h"
@@ -22,6 +23,7 @@
 #include "base/values.h"
 #include "brave/common/network_constants.h"
 #include "brave/common/pref_names.h"
+#include "brave/components/brave_referrals/browser/referral_headers_matcher.h"
 #include "brave/components/brave_referrals/common/pref_names.h"
 #include "brave_base/random.h"
 #include "chrome/browser/browser_process.h"
@@ -36,7 +38,6 @@
 #include "content/public/browser/browser_thread.h"
 #include "content/public/browser/page_navigator.h"
 #include "content/public/common/referrer.h"
-#include "extensions/common/url_pattern.h"
 #include "net/base/load_flags.h"
 #include "net/traffic_annotation/network_traffic_annotation.h"
 #include "services/network/public/cpp/resource_request.h"
@@ -172,33 +173,17 @@ bool BraveReferralsService::GetMatchingReferralHeaders(
     const base::DictionaryValue** request_headers_dict,
     const GURL& url) {
   // If the domain for this request matches one of our target domains,
-  // set the associated custom headers.
-  for (const auto& headers_value : referral_headers_list) {
-    const base::Value* domains_list =
-        headers_value.FindKeyOfType("domains", base::Value::Type::LIST);
-    if (!domains_list) {
-      LOG(WARNING) << "Failed to retrieve 'domains' key from referral headers";
-      continue;
-    }
-    const base::Value* headers_dict =
-        headers_value.FindKeyOfType("headers", base::Value::Type::DICTIONARY);
-    if (!headers_dict) {
-      LOG(WARNING) << "Failed to retrieve 'headers' key from referral headers";
-      continue;
-    }
-    for (const auto& domain_value : domains_list->GetList()) {
-      URLPattern url_pattern(URLPattern::SCHEME_HTTPS |
-                             URLPattern::SCHEME_HTTP);
-      url_pattern.SetScheme("*");
-      url_pattern.SetHost(domain_value.GetString());
-      url_pattern.SetPath("/*");
-      url_pattern.SetMatchSubdomains(true);
-      if (!url_pattern.MatchesURL(url))
-        continue;
-      return headers_dict->GetAsDictionary(request_headers_dict);
-    }
-  }
-  return false;
+  // set the associated custom headers. Requests share a matcher which is
+  // rebuilt when the list changes, see BraveRequestHandler.
+  const base::Optional<size_t> index =
+      ReferralHeadersMatcher(referral_headers_list).GetMatchingEntryIndex(url);
+  if (!index)
+    return false;
+
+  const base::Value* headers_dict =
+      referral_headers_list.GetList()[*index].FindKeyOfType(
+          "headers", base::Value::Type::DICTIONARY);
+  return headers_dict->GetAsDictionary(request_headers_dict);
 }
 
 void BraveReferralsService::OnFinalizationChecksTimerFired() {
@@ -0,0 +1,74 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_referrals/browser/referral_headers_matcher.h"
+
+#include "base/logging.h"
+#include "url/gurl.h"
+
+namespace brave {
+
+ReferralHeadersMatcher::ReferralHeadersMatcher(
+    const base::ListValue& referral_headers_list) {
+  for (size_t index = 0; index < referral_headers_list.GetSize(); ++index) {
+    const base::Value& headers_value = referral_headers_list.GetList()[index];
+    const base::Value* domains_list =
+        headers_value.FindKeyOfType("domains", base::Value::Type::LIST);
+    if (!domains_list) {
+      LOG(WARNING) << "Failed to retrieve 'domains' key from referral headers";
+      continue;
+    }
+    const base::Value* headers_dict =
+        headers_value.FindKeyOfType("headers", base::Value::Type::DICTIONARY);
+    if (!headers_dict) {
+      LOG(WARNING) << "Failed to retrieve 'headers' key from referral headers";
+      continue;
+    }
+
+    // Entries earlier in the list take precedence, which the lowest id of
+    // the matching domains reflects.
+    const size_t id = headers_.size();
+    headers_.push_back(headers_dict->Clone());
+    entry_indices_.push_back(index);
+    for (const auto& domain_value : domains_list->GetList()) {
+      if (domain_value.is_string())
+        host_matcher_.Add(domain_value.GetString(), id);
+    }
+  }
+}
+
+ReferralHeadersMatcher::~ReferralHeadersMatcher() = default;
+
+const base::DictionaryValue* ReferralHeadersMatcher::GetMatchingHeaders(
+    const GURL& url) const {
+  const base::Optional<size_t> id = GetMatchingId(url);
+  if (!id)
+    return nullptr;
+
+  const base::DictionaryValue* headers_dict = nullptr;
+  headers_.at(*id).GetAsDictionary(&headers_dict);
+  return headers_dict;
+}
+
+base::Optional<size_t> ReferralHeadersMatcher::GetMatchingEntryIndex(
+    const GURL& url) const {
+  const base::Optional<size_t> id = GetMatchingId(url);
+  if (!id)
+    return base::nullopt;
+  return entry_indices_.at(*id);
+}
+
+base::Optional<size_t> ReferralHeadersMatcher::GetMatchingId(
+    const GURL& url) const {
+  if (!url.SchemeIsHTTPOrHTTPS())
+    return base::nullopt;
+
+  size_t id;
+  if (!host_matcher_.Match(url.host_piece(), &id))
+    return base::nullopt;
+  return id;
+}
+
+}  // namespace brave
@@ -0,0 +1,50 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_REFERRALS_BROWSER_REFERRAL_HEADERS_MATCHER_H_
+#define BRAVE_COMPONENTS_BRAVE_REFERRALS_BROWSER_REFERRAL_HEADERS_MATCHER_H_
+
+#include <vector>
+
+#include "base/macros.h"
+#include "base/optional.h"
+#include "base/values.h"
+#include "brave/common/host_matcher.h"
+
+class GURL;
+
+namespace brave {
+
+// The referral headers list compiled into a matcher of the domains of its
+// entries, so that it is walked once whenever it changes rather than for
+// every request.
+class ReferralHeadersMatcher {
+ public:
+  explicit ReferralHeadersMatcher(const base::ListValue& referral_headers_list);
+  ~ReferralHeadersMatcher();
+
+  // Returns the headers of the first entry with a domain matching |url|, like
+  // BraveReferralsService::GetMatchingReferralHeaders, or nullptr.
+  const base::DictionaryValue* GetMatchingHeaders(const GURL& url) const;
+
+  // Returns the index in the referral headers list of the entry whose headers
+  // GetMatchingHeaders returns for |url|.
+  base::Optional<size_t> GetMatchingEntryIndex(const GURL& url) const;
+
+ private:
+  // Returns the id of the entry matching |url|, as added to |host_matcher_|.
+  base::Optional<size_t> GetMatchingId(const GURL& url) const;
+
+  std::vector<base::Value> headers_;
+  // The index in the referral headers list of each entry of |headers_|.
+  std::vector<size_t> entry_indices_;
+  HostMatcher host_matcher_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReferralHeadersMatcher);
+};
+
+}  // namespace brave
+
+#endif  // BRAVE_COMPONENTS_BRAVE_REFERRALS_BROWSER_REFERRAL_HEADERS_MATCHER_H_
@@ -0,0 +1,256 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_rewards/browser/diagnostic_logger.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/files/file.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/stringprintf.h"
+#include "base/task/post_task.h"
+#include "base/task_runner_util.h"
+#include "brave/components/brave_rewards/browser/file_util.h"
+#include "brave/components/brave_rewards/browser/logging_util.h"
+
+namespace brave_rewards {
+
+namespace {
+
+// Entries are buffered for up to this long before they are appended to the
+// log, so that a burst of logging is written at once
+constexpr base::TimeDelta kFlushDelay = base::TimeDelta::FromSeconds(1);
+
+const base::FilePath::CharType kPreviousSegmentExtension[] =
+    FILE_PATH_LITERAL(".1");
+
+int CountLines(
+    const std::string& value) {
+  return std::count(value.begin(), value.end(), '\n');
+}
+
+bool TailSegmentAsString(
+    const base::FilePath& path,
+    const int num_lines,
+    std::string* value) {
+  DCHECK(value);
+
+  if (!base::PathExists(path)) {
+    *value = "";
+    return true;
+  }
+
+  base::File file(path, base::File::FLAG_OPEN | base::File::FLAG_READ);
+  if (!file.IsValid() || !TailFileAsString(&file, num_lines, value)) {
+    *value = base::StringPrintf("ERROR: %s", GetLastFileError(&file).c_str());
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace
+
+// Owns the segments of the log, and is only used on the logger's sequence
+class DiagnosticLogger::LogFile {
+ public:
+  LogFile(
+      const base::FilePath& path,
+      const int64_t max_segment_size)
+      : path_(path),
+        previous_segment_path_(path.AddExtension(kPreviousSegmentExtension)),
+        max_segment_size_(max_segment_size) {
+    DETACH_FROM_SEQUENCE(sequence_checker_);
+  }
+
+  ~LogFile() {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  }
+
+  void Append(
+      std::vector<Entry> entries,
+      const size_t dropped_entry_count) {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    if (!InitializeLog(&file_, path_)) {
+      VLOG(0) << "Failed to initialize diagnostic log: "
+          << GetLastFileError(&file_);
+      return;
+    }
+
+    std::string log_entries;
+    if (dropped_entry_count > 0) {
+      log_entries = FriendlyFormatLogEntry(entries.front().time, __FILE__,
+          __LINE__, 0, base::NumberToString(dropped_entry_count) +
+              " diagnostic log entries dropped");
+    }
+
+    for (const auto& entry : entries) {
+      log_entries += FriendlyFormatLogEntry(entry.time, entry.file,
+          entry.line, entry.verbose_level, entry.message);
+    }
+
+    if (!WriteToLog(&file_, log_entries)) {
+      VLOG(0) << "Failed to write to diagnostic log: "
+          << GetLastFileError(&file_);
+      return;
+    }
+
+    const int64_t length = file_.GetLength();
+    if (length == -1 || length <= max_segment_size_) {
+      return;
+    }
+
+    // Start a new segment rather than rewriting this one in place
+    file_.Close();
+    if (!base::Move(path_, previous_segment_path_)) {
+      VLOG(0) << "Failed to rotate diagnostic log";
+    }
+  }
+
+  std::string ReadLastLines(
+      const int num_lines) {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    std::string value;
+    if (!TailSegmentAsString(path_, num_lines, &value)) {
+      return value;
+    }
+
+    const int line_count = CountLines(value);
+    if (num_lines != -1 && line_count >= num_lines) {
+      return value;
+    }
+
+    std::string previous_value;
+    if (!TailSegmentAsString(previous_segment_path_,
+        num_lines == -1 ? -1 : num_lines - line_count, &previous_value)) {
+      // The newer lines are still returned, after the error
+      return previous_value + "\n" + value;
+    }
+
+    return previous_value + value;
+  }
+
+  bool Delete() {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    // Close the log before deleting it (required on Windows)
+    file_.Close();
+
+    const bool deleted_previous_segment =
+        base::DeleteFile(previous_segment_path_);
+    return base::DeleteFile(path_) && deleted_previous_segment;
+  }
+
+ private:
+  const base::FilePath path_;
+  const base::FilePath previous_segment_path_;
+  const int64_t max_segment_size_;
+  base::File file_;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+
+  DISALLOW_COPY_AND_ASSIGN(LogFile);
+};
+
+DiagnosticLogger::DiagnosticLogger(
+    const base::FilePath& path,
+    const int64_t max_segment_size,
+    const size_t max_buffered_entries)
+    : task_runner_(base::CreateSequencedTaskRunner(
+          {base::ThreadPool(), base::MayBlock(),
+           base::TaskPriority::BEST_EFFORT,
+           base::TaskShutdownBehavior::BLOCK_SHUTDOWN})),
+      log_file_(new LogFile(path, max_segment_size),
+          base::OnTaskRunnerDeleter(task_runner_)),
+      max_buffered_entries_(max_buffered_entries) {
+  DCHECK_GT(max_buffered_entries_, 0u);
+}
+
+DiagnosticLogger::~DiagnosticLogger() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+  // The log file is deleted on its sequence after the buffered entries are
+  // appended
+  Flush();
+}
+
+void DiagnosticLogger::Write(
+    const std::string& file,
+    const int line,
+    const int verbose_level,
+    const std::string& message) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+  if (entries_.size() == max_buffered_entries_) {
+    entries_.pop_front();
+    dropped_entry_count_++;
+  }
+
+  entries_.push_back({base::Time::Now(), file, line, verbose_level, message});
+
+  if (!flush_timer_.IsRunning()) {
+    flush_timer_.Start(FROM_HERE, kFlushDelay,
+        base::BindOnce(&DiagnosticLogger::Flush, base::Unretained(this)));
+  }
+}
+
+void DiagnosticLogger::Flush() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+  flush_timer_.Stop();
+
+  if (entries_.empty()) {
+    return;
+  }
+
+  std::vector<Entry> entries(std::make_move_iterator(entries_.begin()),
+      std::make_move_iterator(entries_.end()));
+  entries_.clear();
+
+  // Unretained is safe as |log_file_| is deleted on |task_runner_| after any
+  // task posted here
+  task_runner_->PostTask(FROM_HERE,
+      base::BindOnce(&LogFile::Append,
+          base::Unretained(log_file_.get()),
+          std::move(entries),
+          dropped_entry_count_));
+  dropped_entry_count_ = 0;
+}
+
+void DiagnosticLogger::ReadLastLines(
+    const int num_lines,
+    ReadCallback callback) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+  Flush();
+
+  base::PostTaskAndReplyWithResult(task_runner_.get(), FROM_HERE,
+      base::BindOnce(&LogFile::ReadLastLines,
+          base::Unretained(log_file_.get()),
+          num_lines),
+      std::move(callback));
+}
+
+void DiagnosticLogger::Delete(
+    DeleteCallback callback) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+  flush_timer_.Stop();
+  entries_.clear();
+  dropped_entry_count_ = 0;
+
+  base::PostTaskAndReplyWithResult(task_runner_.get(), FROM_HERE,
+      base::BindOnce(&LogFile::Delete,
+          base::Unretained(log_file_.get())),
+      std::move(callback));
+}
+
+}  // namespace brave_rewards
@@ -0,0 +1,92 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_REWARDS_BROWSER_DIAGNOSTIC_LOGGER_H_
+#define BRAVE_COMPONENTS_BRAVE_REWARDS_BROWSER_DIAGNOSTIC_LOGGER_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/containers/circular_deque.h"
+#include "base/files/file_path.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/sequence_checker.h"
+#include "base/sequenced_task_runner.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+
+namespace brave_rewards {
+
+// Buffers diagnostic log entries in memory and appends them to the log in
+// batches on a low priority sequence of its own, so that logging never delays
+// other file operations. The log is split into two segments, |path| and
+// |path|.1, and the older segment is replaced once the newer one grows beyond
+// |max_segment_size| bytes
+class DiagnosticLogger {
+ public:
+  using ReadCallback = base::OnceCallback<void(const std::string&)>;
+  using DeleteCallback = base::OnceCallback<void(const bool success)>;
+
+  DiagnosticLogger(
+      const base::FilePath& path,
+      const int64_t max_segment_size,
+      const size_t max_buffered_entries);
+  ~DiagnosticLogger();
+
+  // Buffers an entry, dropping the oldest buffered entry if the buffer is full
+  void Write(
+      const std::string& file,
+      const int line,
+      const int verbose_level,
+      const std::string& message);
+
+  // Appends the buffered entries to the log now rather than after a delay
+  void Flush();
+
+  // Reads the last |num_lines| lines of the log, or all of it for -1, after
+  // appending the buffered entries
+  void ReadLastLines(
+      const int num_lines,
+      ReadCallback callback);
+
+  // Deletes the log and discards the buffered entries
+  void Delete(
+      DeleteCallback callback);
+
+  size_t buffered_entry_count() const {
+    return entries_.size();
+  }
+
+ private:
+  struct Entry {
+    base::Time time;
+    std::string file;
+    int line;
+    int verbose_level;
+    std::string message;
+  };
+
+  class LogFile;
+
+  const scoped_refptr<base::SequencedTaskRunner> task_runner_;
+  std::unique_ptr<LogFile, base::OnTaskRunnerDeleter> log_file_;
+
+  const size_t max_buffered_entries_;
+  base::circular_deque<Entry> entries_;
+  size_t dropped_entry_count_ = 0;
+  base::OneShotTimer flush_timer_;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+
+  DISALLOW_COPY_AND_ASSIGN(DiagnosticLogger);
+};
+
+}  // namespace brave_rewards
+
+#endif  // BRAVE_COMPONENTS_BRAVE_REWARDS_BROWSER_DIAGNOSTIC_LOGGER_H_
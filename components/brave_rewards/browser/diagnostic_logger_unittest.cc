@@ -0,0 +1,312 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_rewards/browser/diagnostic_logger.h"
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "base/bind.h"
+#include "base/callback_helpers.h"
+#include "base/files/file.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/logging.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "base/task/post_task.h"
+#include "base/test/bind_test_util.h"
+#include "base/test/task_environment.h"
+#include "base/timer/elapsed_timer.h"
+#include "brave/components/brave_rewards/browser/file_util.h"
+#include "brave/components/brave_rewards/browser/logging_util.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+// npm run test -- brave_unit_tests --filter=DiagnosticLoggerTest.*
+
+namespace brave_rewards {
+
+namespace {
+
+const base::FilePath::CharType kLogFilename[] =
+    FILE_PATH_LITERAL("Rewards.log");
+const base::FilePath::CharType kPreviousSegmentFilename[] =
+    FILE_PATH_LITERAL("Rewards.log.1");
+
+std::string ReadLastLines(
+    DiagnosticLogger* logger,
+    const int num_lines) {
+  std::string value;
+  base::RunLoop run_loop;
+  logger->ReadLastLines(num_lines,
+      base::BindLambdaForTesting([&](const std::string& result) {
+        value = result;
+        run_loop.Quit();
+      }));
+  run_loop.Run();
+  return value;
+}
+
+bool Delete(
+    DiagnosticLogger* logger) {
+  bool success = false;
+  base::RunLoop run_loop;
+  logger->Delete(base::BindLambdaForTesting([&](const bool result) {
+    success = result;
+    run_loop.Quit();
+  }));
+  run_loop.Run();
+  return success;
+}
+
+}  // namespace
+
+class DiagnosticLoggerTest : public testing::Test {
+ public:
+  DiagnosticLoggerTest() = default;
+  ~DiagnosticLoggerTest() override = default;
+
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+  }
+
+  base::FilePath GetLogPath() const {
+    return temp_dir_.GetPath().Append(kLogFilename);
+  }
+
+  base::FilePath GetPreviousSegmentPath() const {
+    return temp_dir_.GetPath().Append(kPreviousSegmentFilename);
+  }
+
+  base::test::TaskEnvironment task_environment_{
+      base::test::TaskEnvironment::TimeSource::MOCK_TIME};
+  base::ScopedTempDir temp_dir_;
+};
+
+TEST_F(DiagnosticLoggerTest, AppendsBufferedEntriesInBatches) {
+  DiagnosticLogger logger(GetLogPath(), 1024 * 1024, 100);
+  logger.Write("foo.cc", 1, 1, "first");
+  logger.Write("bar.cc", 2, 6, "second");
+  EXPECT_EQ(2u, logger.buffered_entry_count());
+
+  task_environment_.RunUntilIdle();
+  EXPECT_FALSE(base::PathExists(GetLogPath()));
+
+  task_environment_.FastForwardBy(base::TimeDelta::FromSeconds(1));
+  task_environment_.RunUntilIdle();
+  EXPECT_EQ(0u, logger.buffered_entry_count());
+
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(GetLogPath(), &contents));
+  EXPECT_NE(std::string::npos, contents.find(":INFO:foo.cc(1)] first\n"));
+  EXPECT_NE(std::string::npos, contents.find(":VERBOSE6:bar.cc(2)] second\n"));
+}
+
+TEST_F(DiagnosticLoggerTest, ReadsBufferedEntries) {
+  DiagnosticLogger logger(GetLogPath(), 1024 * 1024, 100);
+  logger.Write("foo.cc", 1, 1, "first");
+  logger.Write("foo.cc", 2, 1, "second");
+
+  const std::string value = ReadLastLines(&logger, 1);
+  EXPECT_EQ(std::string::npos, value.find("first"));
+  EXPECT_NE(std::string::npos, value.find("second"));
+}
+
+TEST_F(DiagnosticLoggerTest, DropsOldestEntriesWhenBufferIsFull) {
+  DiagnosticLogger logger(GetLogPath(), 1024 * 1024, 2);
+  logger.Write("foo.cc", 1, 1, "first");
+  logger.Write("foo.cc", 2, 1, "second");
+  logger.Write("foo.cc", 3, 1, "third");
+  EXPECT_EQ(2u, logger.buffered_entry_count());
+
+  const std::string value = ReadLastLines(&logger, -1);
+  EXPECT_NE(std::string::npos, value.find("1 diagnostic log entries dropped"));
+  EXPECT_EQ(std::string::npos, value.find("first"));
+  EXPECT_NE(std::string::npos, value.find("second"));
+  EXPECT_NE(std::string::npos, value.find("third"));
+}
+
+TEST_F(DiagnosticLoggerTest, RotatesSegments) {
+  const int64_t kMaxSegmentSize = 1024;
+  DiagnosticLogger logger(GetLogPath(), kMaxSegmentSize, 100);
+  for (int i = 0; i < 100; i++) {
+    logger.Write("foo.cc", i, 1, "entry " + base::NumberToString(i));
+    logger.Flush();
+  }
+  task_environment_.RunUntilIdle();
+
+  // Each segment only grows beyond the limit by the last batch, and the log
+  // is rotated as soon as it does
+  std::string previous_contents;
+  ASSERT_TRUE(base::ReadFileToString(GetPreviousSegmentPath(),
+      &previous_contents));
+  EXPECT_GT(previous_contents.size(), static_cast<size_t>(kMaxSegmentSize));
+  EXPECT_LT(previous_contents.size(), static_cast<size_t>(2 * kMaxSegmentSize));
+  std::string contents;
+  if (base::PathExists(GetLogPath())) {
+    ASSERT_TRUE(base::ReadFileToString(GetLogPath(), &contents));
+  }
+  EXPECT_LE(contents.size(), static_cast<size_t>(kMaxSegmentSize));
+
+  // Lines are read across segments
+  EXPECT_EQ(previous_contents + contents, ReadLastLines(&logger, -1));
+
+  const int num_lines = std::count(contents.begin(), contents.end(), '\n') + 2;
+  const std::string value = ReadLastLines(&logger, num_lines);
+  EXPECT_EQ(num_lines, std::count(value.begin(), value.end(), '\n'));
+  EXPECT_TRUE(base::EndsWith(value, "] entry 99\n",
+      base::CompareCase::SENSITIVE));
+  EXPECT_TRUE(base::EndsWith(previous_contents + contents, value,
+      base::CompareCase::SENSITIVE));
+}
+
+TEST_F(DiagnosticLoggerTest, ReadsCurrentSegmentWhenPreviousSegmentFails) {
+  DiagnosticLogger logger(GetLogPath(), 1024 * 1024, 100);
+  logger.Write("foo.cc", 1, 1, "first");
+  logger.Flush();
+
+  // A directory cannot be read as a segment
+  ASSERT_TRUE(base::CreateDirectory(GetPreviousSegmentPath()));
+
+  const std::string value = ReadLastLines(&logger, -1);
+  EXPECT_TRUE(base::StartsWith(value, "ERROR: ",
+      base::CompareCase::SENSITIVE));
+  EXPECT_NE(std::string::npos, value.find(":INFO:foo.cc(1)] first\n"));
+}
+
+TEST_F(DiagnosticLoggerTest, Delete) {
+  DiagnosticLogger logger(GetLogPath(), 1024, 100);
+  for (int i = 0; i < 100; i++) {
+    logger.Write("foo.cc", i, 1, "entry " + base::NumberToString(i));
+    logger.Flush();
+  }
+  logger.Write("foo.cc", 100, 1, "buffered");
+
+  EXPECT_TRUE(Delete(&logger));
+  EXPECT_EQ(0u, logger.buffered_entry_count());
+  EXPECT_FALSE(base::PathExists(GetLogPath()));
+  EXPECT_FALSE(base::PathExists(GetPreviousSegmentPath()));
+  EXPECT_EQ("", ReadLastLines(&logger, -1));
+}
+
+TEST_F(DiagnosticLoggerTest, AppendsBufferedEntriesWhenDestroyed) {
+  auto logger = std::make_unique<DiagnosticLogger>(GetLogPath(), 1024, 100);
+  logger->Write("foo.cc", 1, 1, "first");
+  logger.reset();
+  task_environment_.RunUntilIdle();
+
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(GetLogPath(), &contents));
+  EXPECT_NE(std::string::npos, contents.find("first"));
+}
+
+// Runs database-like transactions on the sequence that database transactions
+// run on, logging a burst of verbose entries before each one as the ledger
+// does around its database calls, and compares how long the transactions
+// take with the entries written on that sequence and with the logger
+//
+// Disabled by default, as it is a benchmark. Run it with
+// --gtest_also_run_disabled_tests.
+TEST(DiagnosticLoggerBenchmarkTest, DISABLED_DatabaseTransactionLatencyBenchmark) {
+  const int kTransactionCount = 50;
+  const int kEntriesPerTransaction = 100;
+  const std::string kMessage(200, 'x');
+
+  base::test::TaskEnvironment task_environment;
+  base::ScopedTempDir temp_dir;
+  ASSERT_TRUE(temp_dir.CreateUniqueTempDir());
+
+  // The sequence database transactions run on
+  auto file_task_runner = base::CreateSequencedTaskRunner(
+      {base::ThreadPool(), base::MayBlock(), base::TaskPriority::USER_VISIBLE,
+       base::TaskShutdownBehavior::BLOCK_SHUTDOWN});
+
+  // Each transaction appends a page to a database file and syncs it
+  base::File database(temp_dir.GetPath().AppendASCII("database"),
+      base::File::FLAG_CREATE_ALWAYS | base::File::FLAG_APPEND);
+  ASSERT_TRUE(database.IsValid());
+  const std::string kPage(4096, 'p');
+
+  // Returns the average time from posting a transaction until it completed
+  auto measure_transactions = [&](
+      const base::RepeatingCallback<void(const std::string&)>& log,
+      const base::RepeatingClosure& log_burst_done) {
+    base::TimeDelta latency;
+    for (int i = 0; i < kTransactionCount; i++) {
+      for (int j = 0; j < kEntriesPerTransaction; j++) {
+        log.Run(kMessage + base::NumberToString(j));
+      }
+      log_burst_done.Run();
+
+      base::RunLoop run_loop;
+      const base::TimeTicks posted = base::TimeTicks::Now();
+      file_task_runner->PostTaskAndReply(FROM_HERE,
+          base::BindLambdaForTesting([&]() {
+            ASSERT_EQ(static_cast<int>(kPage.size()),
+                database.WriteAtCurrentPos(kPage.data(), kPage.size()));
+            ASSERT_TRUE(database.Flush());
+          }),
+          base::BindLambdaForTesting([&]() {
+            latency += base::TimeTicks::Now() - posted;
+            run_loop.Quit();
+          }));
+      run_loop.Run();
+    }
+    return latency / kTransactionCount;
+  };
+
+  // Previously every entry was formatted and written by its own task on the
+  // database sequence, tailing the log once it grew too large
+  base::File log;
+  const base::FilePath log_path = temp_dir.GetPath().Append(kLogFilename);
+  const base::TimeDelta task_latency = measure_transactions(
+      base::BindLambdaForTesting([&](const std::string& message) {
+        file_task_runner->PostTask(FROM_HERE,
+            base::BindLambdaForTesting([&, message]() {
+              ASSERT_TRUE(InitializeLog(&log, log_path));
+              ASSERT_TRUE(WriteToLog(&log, FriendlyFormatLogEntry(
+                  base::Time::Now(), __FILE__, __LINE__, 6, message)));
+              if (log.GetLength() > 10 * 1024 * 1024) {
+                ASSERT_TRUE(TailFile(&log, 20000));
+              }
+            }));
+      }),
+      base::DoNothing());
+  file_task_runner->PostTask(FROM_HERE,
+      base::BindLambdaForTesting([&]() { log.Close(); }));
+  task_environment.RunUntilIdle();
+
+  // The logger appends each burst as one batch on its own sequence, while
+  // the transaction runs. Flushing every burst rather than once a second is
+  // the worst case for the logger
+  DiagnosticLogger logger(temp_dir.GetPath().AppendASCII("Logger.log"),
+      5 * 1024 * 1024, 10000);
+  const base::TimeDelta logger_latency = measure_transactions(
+      base::BindLambdaForTesting([&](const std::string& message) {
+        logger.Write(__FILE__, __LINE__, 6, message);
+      }),
+      base::BindLambdaForTesting([&]() { logger.Flush(); }));
+  task_environment.RunUntilIdle();
+
+  std::string contents;
+  ASSERT_TRUE(base::ReadFileToString(
+      temp_dir.GetPath().AppendASCII("Logger.log"), &contents));
+  EXPECT_EQ(kTransactionCount * kEntriesPerTransaction,
+      std::count(contents.begin(), contents.end(), '\n'));
+
+  database.Close();
+
+  LOG(INFO) << "Database transactions took "
+            << logger_latency.InMicroseconds() << "us on average with "
+            << kEntriesPerTransaction << " verbose level 6 log entries "
+            << "before each using the logger ("
+            << task_latency.InMicroseconds()
+            << "us writing each entry on the database sequence)";
+}
+
+}  // namespace brave_rewards
@@ -15,6 +15,7 @@
 
 #include "base/base64.h"
 #include "base/bind.h"
+#include "base/callback_helpers.h"
 #include "base/command_line.h"
 #include "base/containers/flat_map.h"
 #include "base/files/file_util.h"
@@ -45,9 +46,8 @@
 #include "brave/components/brave_ads/browser/ads_service_factory.h"
 #include "brave/components/brave_ads/browser/buildflags/buildflags.h"
 #include "brave/components/brave_rewards/browser/android_util.h"
-#include "brave/components/brave_rewards/browser/file_util.h"
+#include "brave/components/brave_rewards/browser/diagnostic_logger.h"
 #include "brave/components/brave_rewards/browser/logging.h"
-#include "brave/components/brave_rewards/browser/logging_util.h"
 #include "brave/components/brave_rewards/browser/rewards_notification_service.h"
 #include "brave/components/brave_rewards/browser/rewards_notification_service_impl.h"
 #include "brave/components/brave_rewards/browser/rewards_p3a.h"
@@ -105,7 +105,7 @@ static const unsigned int kRetriesCountOnNetworkChange = 1;
 namespace {
 
 const int kDiagnosticLogMaxVerboseLevel = 6;
-const int kTailDiagnosticLogToNumLines = 20000;
+const size_t kDiagnosticLogMaxBufferedEntries = 10000;
 const int kDiagnosticLogMaxFileSize = 10 * (1024 * 1024);
 const char pref_prefix[] = "brave.rewards";
 
@@ -179,6 +179,19 @@ std::string LoadOnFileTaskRunner(const base::FilePath& path) {
   return data;
 }
 
+bool SavePublisherPrefixListOnFileTaskRunner(
+    const base::FilePath& path,
+    const std::string& prefixes) {
+  return base::ImportantFileWriter::WriteFileAtomically(path, prefixes);
+}
+
+base::File OpenPublisherPrefixListOnFileTaskRunner(
+    const base::FilePath& path) {
+  // The ledger process maps the file, so allow it to be replaced while open
+  return base::File(path, base::File::FLAG_OPEN | base::File::FLAG_READ |
+      base::File::FLAG_SHARE_DELETE);
+}
+
 net::NetworkTrafficAnnotationTag
 GetNetworkTrafficAnnotationTagForFaviconFetch() {
   return net::DefineNetworkTrafficAnnotation(
@@ -287,12 +300,16 @@ const base::FilePath::StringType kLedger_state(L"ledger_state");
 const base::FilePath::StringType kPublisher_state(L"publisher_state");
 const base::FilePath::StringType kPublisher_info_db(L"publisher_info_db");
 const base::FilePath::StringType kPublishers_list(L"publishers_list");
+const base::FilePath::StringType kPublisher_prefix_list(
+    L"publisher_prefix_list");
 #else
 const base::FilePath::StringType kDiagnosticLogPath("Rewards.log");
 const base::FilePath::StringType kLedger_state("ledger_state");
 const base::FilePath::StringType kPublisher_state("publisher_state");
 const base::FilePath::StringType kPublisher_info_db("publisher_info_db");
 const base::FilePath::StringType kPublishers_list("publishers_list");
+const base::FilePath::StringType kPublisher_prefix_list(
+    "publisher_prefix_list");
 #endif
 
 #if BUILDFLAG(ENABLE_GREASELION)
@@ -311,11 +328,16 @@ RewardsServiceImpl::RewardsServiceImpl(Profile* profile)
           {base::ThreadPool(), base::MayBlock(),
            base::TaskPriority::USER_VISIBLE,
            base::TaskShutdownBehavior::BLOCK_SHUTDOWN})),
-      diagnostic_log_path_(profile_->GetPath().Append(kDiagnosticLogPath)),
+      diagnostic_logger_(std::make_unique<DiagnosticLogger>(
+          profile_->GetPath().Append(kDiagnosticLogPath),
+          kDiagnosticLogMaxFileSize / 2,
+          kDiagnosticLogMaxBufferedEntries)),
       ledger_state_path_(profile_->GetPath().Append(kLedger_state)),
       publisher_state_path_(profile_->GetPath().Append(kPublisher_state)),
       publisher_info_db_path_(profile->GetPath().Append(kPublisher_info_db)),
       publisher_list_path_(profile->GetPath().Append(kPublishers_list)),
+      publisher_prefix_list_path_(
+          profile->GetPath().Append(kPublisher_prefix_list)),
       notification_service_(new RewardsNotificationServiceImpl(profile)),
       next_timer_id_(0) {
   // Set up the rewards data source
@@ -409,9 +431,6 @@ void RewardsServiceImpl::StartLedger() {
     return;
   }
 
-  ledger_database_.reset(
-      ledger::LedgerDatabase::CreateInstance(publisher_info_db_path_));
-
   BLOG(1, "Starting ledger process");
 
   if (!bat_ledger_service_.is_bound()) {
@@ -447,6 +466,10 @@ void RewardsServiceImpl::StartLedger() {
     }
   }
 
+  ledger_database_.reset(ledger::LedgerDatabase::CreateInstance(
+      publisher_info_db_path_,
+      use_wal_journal_mode_));
+
   bat_ledger_service_->Create(
       bat_ledger_client_receiver_.BindNewEndpointAndPassRemote(),
       bat_ledger_.BindNewEndpointAndPassReceiver(),
@@ -1432,6 +1455,8 @@ void RewardsServiceImpl::OnStopLedgerForCompleteReset(
     const ledger::type::Result result) {
   profile_->GetPrefs()->ClearPrefsWithPrefixSilently(pref_prefix);
 
+  diagnostic_logger_->Delete(base::DoNothing());
+
   base::PostTaskAndReplyWithResult(
       file_task_runner_.get(),
       FROM_HERE,
@@ -1445,15 +1470,12 @@ void RewardsServiceImpl::OnStopLedgerForCompleteReset(
 }
 
 bool RewardsServiceImpl::ResetOnFilesTaskRunner() {
-  // Close any open files before deleting them (required on Windows)
-  diagnostic_log_.Close();
-
   const std::vector<base::FilePath> paths = {
     ledger_state_path_,
     publisher_state_path_,
     publisher_info_db_path_,
-    diagnostic_log_path_,
     publisher_list_path_,
+    publisher_prefix_list_path_,
   };
 
   bool res = true;
@@ -2243,32 +2265,6 @@ void RewardsServiceImpl::ShowNotificationTipsPaid(bool ac_enabled) {
       "rewards_notification_tips_processed");
 }
 
-bool RewardsServiceImpl::MaybeTailDiagnosticLog(
-    const int num_lines) {
-  if (!diagnostic_log_.IsValid()) {
-    return false;
-  }
-
-  static bool first_run = true;
-
-  const int64_t length = diagnostic_log_.GetLength();
-  if (length == -1) {
-    return false;
-  }
-
-  if (!first_run && length <= kDiagnosticLogMaxFileSize) {
-    return true;
-  }
-
-  first_run = false;
-
-  if (!TailFile(&diagnostic_log_, num_lines)) {
-    return false;
-  }
-
-  return true;
-}
-
 void RewardsServiceImpl::DiagnosticLog(
     const std::string& file,
     const int line,
@@ -2286,120 +2282,18 @@ void RewardsServiceImpl::DiagnosticLog(
     return;
   }
 
-  base::PostTaskAndReplyWithResult(file_task_runner_.get(), FROM_HERE,
-      base::BindOnce(&RewardsServiceImpl::WriteToDiagnosticLogOnFileTaskRunner,
-          base::Unretained(this),
-          diagnostic_log_path_,
-          kTailDiagnosticLogToNumLines,
-          file,
-          line,
-          verbose_level,
-          message),
-      base::BindOnce(&RewardsServiceImpl::OnWriteToLogOnFileTaskRunner,
-          AsWeakPtr()));
-}
-
-bool RewardsServiceImpl::WriteToDiagnosticLogOnFileTaskRunner(
-    const base::FilePath& log_path,
-    const int num_lines,
-    const std::string& file,
-    const int line,
-    const int verbose_level,
-    const std::string& message) {
-  if (!InitializeLog(&diagnostic_log_, log_path)) {
-    VLOG(0) << "Failed to initialize diagnostic log: "
-        << GetLastFileError(&diagnostic_log_);
-
-    return false;
-  }
-
-  const base::Time time = base::Time::Now();
-
-  const std::string log_entry =
-      FriendlyFormatLogEntry(time, file, line, verbose_level, message);
-
-  if (!WriteToLog(&diagnostic_log_, log_entry)) {
-    VLOG(0) << "Failed to write to diagnostic log: "
-        << GetLastFileError(&diagnostic_log_);
-
-    return false;
-  }
-
-  if (!MaybeTailDiagnosticLog(num_lines)) {
-    VLOG(0) << "Failed to vacuum diagnostic log";
-
-    return false;
-  }
-
-  return true;
-}
-
-void RewardsServiceImpl::OnWriteToLogOnFileTaskRunner(
-    const bool success) {
-  DCHECK(success);
+  diagnostic_logger_->Write(file, line, verbose_level, message);
 }
 
 void RewardsServiceImpl::LoadDiagnosticLog(
       const int num_lines,
       LoadDiagnosticLogCallback callback) {
-  base::PostTaskAndReplyWithResult(file_task_runner_.get(), FROM_HERE,
-      base::BindOnce(&RewardsServiceImpl::LoadDiagnosticLogOnFileTaskRunner,
-          base::Unretained(this),
-          diagnostic_log_path_,
-          num_lines),
-      base::BindOnce(&RewardsServiceImpl::OnLoadDiagnosticLogOnFileTaskRunner,
-          AsWeakPtr(),
-          std::move(callback)));
-}
-
-std::string RewardsServiceImpl::LoadDiagnosticLogOnFileTaskRunner(
-    const base::FilePath& path,
-    const int num_lines) {
-  if (!base::PathExists(path)) {
-    return "";
-  }
-
-  std::string value;
-  if (!TailFileAsString(&diagnostic_log_, num_lines, &value)) {
-    return base::StringPrintf("ERROR: %s",
-        GetLastFileError(&diagnostic_log_).c_str());
-  }
-
-  return value;
-}
-
-void RewardsServiceImpl::OnLoadDiagnosticLogOnFileTaskRunner(
-    LoadDiagnosticLogCallback callback,
-    const std::string& value) {
-  std::move(callback).Run(value);
+  diagnostic_logger_->ReadLastLines(num_lines, std::move(callback));
 }
 
 void RewardsServiceImpl::ClearDiagnosticLog(
     ClearDiagnosticLogCallback callback) {
-  base::PostTaskAndReplyWithResult(file_task_runner_.get(), FROM_HERE,
-      base::BindOnce(&RewardsServiceImpl::ClearDiagnosticLogOnFileTaskRunner,
-          base::Unretained(this),
-          diagnostic_log_path_),
-      base::BindOnce(&RewardsServiceImpl::OnClearDiagnosticLogOnFileTaskRunner,
-          AsWeakPtr(),
-          std::move(callback)));
-}
-
-bool RewardsServiceImpl::ClearDiagnosticLogOnFileTaskRunner(
-    const base::FilePath& path) {
-  if (!base::PathExists(path)) {
-    return true;
-  }
-
-  diagnostic_log_.Close();
-
-  return base::DeleteFile(path);
-}
-
-void RewardsServiceImpl::OnClearDiagnosticLogOnFileTaskRunner(
-    ClearDiagnosticLogCallback callback,
-    const bool success) {
-  std::move(callback).Run(success);
+  diagnostic_logger_->Delete(std::move(callback));
 }
 
 void RewardsServiceImpl::Log(
@@ -2513,6 +2407,18 @@ void RewardsServiceImpl::HandleFlags(const std::string& options) {
       } else {
         should_persist_logs_ = false;
       }
+
+      continue;
+    }
+
+    if (name == "wal") {
+      const std::string lower = base::ToLowerASCII(value);
+
+      if (lower == "true" || lower == "1") {
+        use_wal_journal_mode_ = true;
+      } else {
+        use_wal_journal_mode_ = false;
+      }
     }
   }
 }
@@ -3369,25 +3275,40 @@ void RewardsServiceImpl::WalletDisconnected(const std::string& wallet_type) {
 }
 
 void RewardsServiceImpl::DeleteLog(ledger::ResultCallback callback) {
-  diagnostic_log_.Close();
+  diagnostic_logger_->Delete(
+      base::BindOnce(
+          &RewardsServiceImpl::OnDeleteLog,
+          AsWeakPtr(),
+          std::move(callback)));
+}
+
+void RewardsServiceImpl::OnDeleteLog(
+    ledger::ResultCallback callback,
+    const bool success) {
+  const auto result = success
+      ? ledger::type::Result::LEDGER_OK
+      : ledger::type::Result::LEDGER_ERROR;
+  callback(result);
+}
+
+void RewardsServiceImpl::SavePublisherPrefixList(
+    const std::string& prefixes,
+    ledger::client::ResultCallback callback) {
   base::PostTaskAndReplyWithResult(
       file_task_runner_.get(),
       FROM_HERE,
       base::BindOnce(
-          &RewardsServiceImpl::DeleteLogTaskRunner,
-          base::Unretained(this)),
+          &SavePublisherPrefixListOnFileTaskRunner,
+          publisher_prefix_list_path_,
+          prefixes),
       base::BindOnce(
-          &RewardsServiceImpl::OnDeleteLog,
+          &RewardsServiceImpl::OnSavePublisherPrefixList,
           AsWeakPtr(),
           std::move(callback)));
 }
 
-bool RewardsServiceImpl::DeleteLogTaskRunner() {
-  return base::DeleteFile(diagnostic_log_path_);
-}
-
-void RewardsServiceImpl::OnDeleteLog(
-    ledger::ResultCallback callback,
+void RewardsServiceImpl::OnSavePublisherPrefixList(
+    ledger::client::ResultCallback callback,
     const bool success) {
   const auto result = success
       ? ledger::type::Result::LEDGER_OK
@@ -3395,6 +3316,26 @@ void RewardsServiceImpl::OnDeleteLog(
   callback(result);
 }
 
+void RewardsServiceImpl::LoadPublisherPrefixList(
+    ledger::client::LoadPublisherPrefixListCallback callback) {
+  base::PostTaskAndReplyWithResult(
+      file_task_runner_.get(),
+      FROM_HERE,
+      base::BindOnce(
+          &OpenPublisherPrefixListOnFileTaskRunner,
+          publisher_prefix_list_path_),
+      base::BindOnce(
+          &RewardsServiceImpl::OnLoadPublisherPrefixList,
+          AsWeakPtr(),
+          std::move(callback)));
+}
+
+void RewardsServiceImpl::OnLoadPublisherPrefixList(
+    ledger::client::LoadPublisherPrefixListCallback callback,
+    base::File file) {
+  callback(std::move(file));
+}
+
 void RewardsServiceImpl::GetEventLogs(GetEventLogsCallback callback) {
   if (!Connected()) {
     return;
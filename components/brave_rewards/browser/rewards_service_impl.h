@@ -69,6 +69,7 @@ class RewardsFlagBrowserTest;
 
 namespace brave_rewards {
 
+class DiagnosticLogger;
 class RewardsNotificationServiceImpl;
 class RewardsBrowserTest;
 
@@ -550,49 +551,20 @@ class RewardsServiceImpl : public RewardsService,
       SavePublisherInfoCallback callback,
       const ledger::type::Result result);
 
-  bool MaybeTailDiagnosticLog(
-      const int num_lines);
-
   void DiagnosticLog(
       const std::string& file,
       const int line,
       const int verbose_level,
       const std::string& message) override;
 
-  bool WriteToDiagnosticLogOnFileTaskRunner(
-      const base::FilePath& log_path,
-      const int num_lines,
-      const std::string& file,
-      const int line,
-      const int verbose_level,
-      const std::string& message);
-
-  void OnWriteToLogOnFileTaskRunner(
-    const bool success);
-
   void LoadDiagnosticLog(
       const int num_lines,
       LoadDiagnosticLogCallback callback) override;
 
-  std::string LoadDiagnosticLogOnFileTaskRunner(
-      const base::FilePath& path,
-      const int num_lines);
-
-  void OnLoadDiagnosticLogOnFileTaskRunner(
-      LoadDiagnosticLogCallback callback,
-      const std::string& value);
-
   void ClearDiagnosticLog(ClearDiagnosticLogCallback callback) override;
 
   void CompleteReset(SuccessCallback callback) override;
 
-  bool ClearDiagnosticLogOnFileTaskRunner(
-      const base::FilePath& path);
-
-  void OnClearDiagnosticLogOnFileTaskRunner(
-      ClearDiagnosticLogCallback callback,
-      const bool success);
-
   void Log(
       const char* file,
       const int line,
@@ -655,6 +627,13 @@ class RewardsServiceImpl : public RewardsService,
 
   void DeleteLog(ledger::ResultCallback callback) override;
 
+  void SavePublisherPrefixList(
+      const std::string& prefixes,
+      ledger::client::ResultCallback callback) override;
+
+  void LoadPublisherPrefixList(
+      ledger::client::LoadPublisherPrefixListCallback callback) override;
+
   // end ledger::LedgerClient
 
   // Mojo Proxy methods
@@ -723,10 +702,16 @@ class RewardsServiceImpl : public RewardsService,
 
   void OnCompleteReset(SuccessCallback callback, const bool success);
 
-  bool DeleteLogTaskRunner();
-
   void OnDeleteLog(ledger::ResultCallback callback, const bool success);
 
+  void OnSavePublisherPrefixList(
+      ledger::client::ResultCallback callback,
+      const bool success);
+
+  void OnLoadPublisherPrefixList(
+      ledger::client::LoadPublisherPrefixListCallback callback,
+      base::File file);
+
   void OnGetEventLogs(
       GetEventLogsCallback callback,
       ledger::type::EventLogs logs);
@@ -757,12 +742,12 @@ class RewardsServiceImpl : public RewardsService,
   mojo::AssociatedRemote<bat_ledger::mojom::BatLedger> bat_ledger_;
   mojo::Remote<bat_ledger::mojom::BatLedgerService> bat_ledger_service_;
   const scoped_refptr<base::SequencedTaskRunner> file_task_runner_;
-  const base::FilePath diagnostic_log_path_;
-  base::File diagnostic_log_;
+  std::unique_ptr<DiagnosticLogger> diagnostic_logger_;
   const base::FilePath ledger_state_path_;
   const base::FilePath publisher_state_path_;
   const base::FilePath publisher_info_db_path_;
   const base::FilePath publisher_list_path_;
+  const base::FilePath publisher_prefix_list_path_;
   std::unique_ptr<ledger::LedgerDatabase> ledger_database_;
   std::unique_ptr<RewardsNotificationServiceImpl> notification_service_;
   base::ObserverList<RewardsServicePrivateObserver> private_observers_;
@@ -783,6 +768,7 @@ class RewardsServiceImpl : public RewardsService,
   bool ledger_for_testing_ = false;
   bool resetting_rewards_ = false;
   bool should_persist_logs_ = false;
+  bool use_wal_journal_mode_ = false;
 
   GetTestResponseCallback test_response_callback_;
 
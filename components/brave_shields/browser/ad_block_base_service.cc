@@ -10,107 +10,63 @@
 #include <utility>
 #include <vector>
 
+#include "base/atomic_sequence_num.h"
 #include "base/bind.h"
+#include "base/feature_list.h"
 #include "base/files/file_path.h"
+#include "base/hash/hash.h"
 #include "base/json/json_reader.h"
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/task/post_task.h"
+#include "base/time/time.h"
 #include "brave/browser/net/url_context.h"
 #include "brave/common/pref_names.h"
 #include "brave/components/brave_component_updater/browser/dat_file_util.h"
 #include "brave/components/brave_shields/common/brave_shield_constants.h"
+#include "brave/components/brave_shields/common/features.h"
 #include "brave/vendor/adblock_rust_ffi/src/wrapper.hpp"
 #include "components/prefs/pref_service.h"
 #include "content/public/browser/browser_task_traits.h"
 #include "content/public/browser/browser_thread.h"
-#include "net/base/registry_controlled_domains/registry_controlled_domain.h"
-#include "url/origin.h"
 
 using brave_component_updater::BraveComponent;
 using content::BrowserThread;
-using namespace net::registry_controlled_domains;  // NOLINT
+
+namespace brave_shields {
 
 namespace {
 
-std::string ResourceTypeToString(blink::mojom::ResourceType resource_type) {
-  std::string filter_option = "";
-  switch (resource_type) {
-    // top level page
-    case blink::mojom::ResourceType::kMainFrame:
-      filter_option = "main_frame";
-      break;
-    // frame or iframe
-    case blink::mojom::ResourceType::kSubFrame:
-      filter_option = "sub_frame";
-      break;
-    // a CSS stylesheet
-    case blink::mojom::ResourceType::kStylesheet:
-      filter_option = "stylesheet";
-      break;
-    // an external script
-    case blink::mojom::ResourceType::kScript:
-      filter_option = "script";
-      break;
-    // an image (jpg/gif/png/etc)
-    case blink::mojom::ResourceType::kFavicon:
-    case blink::mojom::ResourceType::kImage:
-      filter_option = "image";
-      break;
-    // a font
-    case blink::mojom::ResourceType::kFontResource:
-      filter_option = "font";
-      break;
-    // an "other" subresource.
-    case blink::mojom::ResourceType::kSubResource:
-      filter_option = "other";
-      break;
-    // an object (or embed) tag for a plugin.
-    case blink::mojom::ResourceType::kObject:
-      filter_option = "object";
-      break;
-    // a media resource.
-    case blink::mojom::ResourceType::kMedia:
-      filter_option = "media";
-      break;
-    // a XMLHttpRequest
-    case blink::mojom::ResourceType::kXhr:
-      filter_option = "xhr";
-      break;
-    // a ping request for <a ping>/sendBeacon.
-    case blink::mojom::ResourceType::kPing:
-      filter_option = "ping";
-      break;
-    // the main resource of a dedicated worker.
-    case blink::mojom::ResourceType::kWorker:
-    // the main resource of a shared worker.
-    case blink::mojom::ResourceType::kSharedWorker:
-    // an explicitly requested prefetch
-    case blink::mojom::ResourceType::kPrefetch:
-    // the main resource of a service worker.
-    case blink::mojom::ResourceType::kServiceWorker:
-    // a report of Content Security Policy violations.
-    case blink::mojom::ResourceType::kCspReport:
-    // a resource that a plugin requested.
-    case blink::mojom::ResourceType::kPluginResource:
-    default:
-      break;
-  }
-  return filter_option;
-}
+// Shared by all services, so that cached decisions of one set of engines are
+// never mistaken for those of another.
+base::AtomicSequenceNumber g_engine_generation;
 
-}  // namespace
+// Requests only hold on to an engine while they are matched against it.
+constexpr base::TimeDelta kEngineInUseRetryDelay =
+    base::TimeDelta::FromMilliseconds(10);
 
-namespace brave_shields {
+}  // namespace
 
 AdBlockBaseService::AdBlockBaseService(BraveComponent::Delegate* delegate)
     : BaseBraveShieldsService(delegate),
-      ad_block_client_(new adblock::Engine()),
+      snapshot_(base::MakeRefCounted<AdBlockEngineSnapshot>(
+          std::make_unique<adblock::Engine>(), 0)),
       weak_factory_(this) {}
 
 AdBlockBaseService::~AdBlockBaseService() {
-  GetTaskRunner()->DeleteSoon(FROM_HERE, ad_block_client_.release());
+  GetTaskRunner()->ReleaseSoon(FROM_HERE, std::move(snapshot_));
+}
+
+// static
+bool AdBlockBaseService::IsParallelMatchingEnabled() {
+  return base::FeatureList::IsEnabled(
+      features::kBraveAdblockParallelMatching);
+}
+
+scoped_refptr<AdBlockEngineSnapshot> AdBlockBaseService::GetEngineSnapshot() {
+  base::AutoLock lock(snapshot_lock_);
+  return snapshot_;
 }
 
 bool AdBlockBaseService::ShouldStartRequest(
@@ -120,40 +76,55 @@ bool AdBlockBaseService::ShouldStartRequest(
     bool* did_match_exception,
     bool* cancel_request_explicitly,
     std::string* mock_data_url) {
-  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
+  DCHECK(IsParallelMatchingEnabled() ||
+         GetTaskRunner()->RunsTasksInCurrentSequence());
+
+  return ShouldStartRequestWithCachedSnapshots(
+      {GetEngineSnapshot()}, url, resource_type, tab_host, did_match_exception,
+      cancel_request_explicitly, mock_data_url, nullptr);
+}
 
-  // Determine third-party here so the library doesn't need to figure it out.
-  // CreateFromNormalizedTuple is needed because SameDomainOrHost needs
-  // a URL or origin and not a string to a host name.
-  bool is_third_party = !SameDomainOrHost(
-      url,
-      url::Origin::CreateFromNormalizedTuple("https", tab_host.c_str(), 80),
-      INCLUDE_PRIVATE_REGISTRIES);
-  bool explicit_cancel;
-  bool saved_from_exception;
-  if (ad_block_client_->matches(
-          url.spec(), url.host(), tab_host, is_third_party,
-          ResourceTypeToString(resource_type), &explicit_cancel,
-          &saved_from_exception, mock_data_url)) {
-    if (cancel_request_explicitly) {
-      *cancel_request_explicitly = explicit_cancel;
-    }
-    // We'd only possibly match an exception filter if we're returning true.
-    if (did_match_exception) {
-      *did_match_exception = false;
-    }
-    // LOG(ERROR) << "AdBlockBaseService::ShouldStartRequest(), host: "
-    //  << tab_host
-    //  << ", resource type: " << resource_type
-    //  << ", url.spec(): " << url.spec();
-    return false;
+bool AdBlockBaseService::ShouldStartRequestWithCachedSnapshots(
+    const AdBlockEngineSnapshots& snapshots,
+    const GURL& url,
+    blink::mojom::ResourceType resource_type,
+    const std::string& tab_host,
+    bool* did_match_exception,
+    bool* cancel_request_explicitly,
+    std::string* mock_data_url,
+    bool* cache_hit) {
+  // Generations are unique across all services, so together they identify
+  // the exact engines a decision was made by.
+  uint64_t generation = 0;
+  for (const auto& snapshot : snapshots) {
+    if (snapshot)
+      generation = base::HashInts64(generation, snapshot->generation());
   }
 
-  if (did_match_exception) {
-    *did_match_exception = saved_from_exception;
+  AdBlockDecision decision;
+  bool hit = decision_cache_.Get(url, resource_type, tab_host, generation,
+                                 &decision);
+  if (!hit) {
+    decision.generation = generation;
+    decision.should_start = ShouldStartRequestWithSnapshots(
+        snapshots, url, resource_type, tab_host, &decision.did_match_exception,
+        &decision.cancel_request_explicitly, &decision.mock_data_url);
+    decision_cache_.Put(url, resource_type, tab_host, decision);
+  }
+  if (cache_hit) {
+    *cache_hit = hit;
   }
 
-  return true;
+  if (did_match_exception) {
+    *did_match_exception = decision.did_match_exception;
+  }
+  if (!decision.should_start && cancel_request_explicitly) {
+    *cancel_request_explicitly = decision.cancel_request_explicitly;
+  }
+  if (mock_data_url && !decision.mock_data_url.empty()) {
+    *mock_data_url = decision.mock_data_url;
+  }
+  return decision.should_start;
 }
 
 void AdBlockBaseService::EnableTag(const std::string& tag, bool enabled) {
@@ -164,17 +135,17 @@ void AdBlockBaseService::EnableTag(const std::string& tag, bool enabled) {
     return;
   }
 
+  std::vector<std::string>::iterator it =
+      std::find(tags_.begin(), tags_.end(), tag);
+  if (enabled == (it != tags_.end()))
+    return;
+
   if (enabled) {
-    ad_block_client_->addTag(tag);
     tags_.push_back(tag);
   } else {
-    ad_block_client_->removeTag(tag);
-    std::vector<std::string>::iterator it =
-        std::find(tags_.begin(), tags_.end(), tag);
-    if (it != tags_.end()) {
-      tags_.erase(it);
-    }
+    tags_.erase(it);
   }
+  ScheduleApplyTagsAndResources();
 }
 
 void AdBlockBaseService::AddResources(const std::string& resources) {
@@ -185,8 +156,9 @@ void AdBlockBaseService::AddResources(const std::string& resources) {
     return;
   }
 
-  ad_block_client_->addResources(resources);
   resources_ = resources;
+  resources_changed_ = true;
+  ScheduleApplyTagsAndResources();
 }
 
 bool AdBlockBaseService::TagExists(const std::string& tag) {
@@ -196,7 +168,8 @@ bool AdBlockBaseService::TagExists(const std::string& tag) {
 base::Optional<base::Value> AdBlockBaseService::UrlCosmeticResources(
         const std::string& url) {
   DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
-  return base::JSONReader::Read(ad_block_client_->urlCosmeticResources(url));
+  return base::JSONReader::Read(
+      GetEngineSnapshot()->engine()->urlCosmeticResources(url));
 }
 
 base::Optional<base::Value> AdBlockBaseService::HiddenClassIdSelectors(
@@ -205,7 +178,8 @@ base::Optional<base::Value> AdBlockBaseService::HiddenClassIdSelectors(
         const std::vector<std::string>& exceptions) {
   DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
   return base::JSONReader::Read(
-      ad_block_client_->hiddenClassIdSelectors(classes, ids, exceptions));
+      GetEngineSnapshot()->engine()->hiddenClassIdSelectors(classes, ids,
+                                                            exceptions));
 }
 
 void AdBlockBaseService::GetDATFileData(const base::FilePath& dat_file_path) {
@@ -218,35 +192,110 @@ void AdBlockBaseService::GetDATFileData(const base::FilePath& dat_file_path) {
 }
 
 void AdBlockBaseService::OnGetDATFileData(GetDATFileDataResult result) {
-  if (result.second.empty()) {
+  if (!result) {
     LOG(ERROR) << "Could not obtain ad block data";
     return;
   }
-  if (!result.first.get()) {
-    LOG(ERROR) << "Failed to deserialize ad block data";
-    return;
-  }
   GetTaskRunner()->PostTask(
       FROM_HERE, base::BindOnce(&AdBlockBaseService::UpdateAdBlockClient,
-                                base::Unretained(this),
-                                std::move(result.first)));
+                                base::Unretained(this), std::move(result)));
 }
 
 void AdBlockBaseService::UpdateAdBlockClient(
     std::unique_ptr<adblock::Engine> ad_block_client) {
   DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
-  ad_block_client_ = std::move(ad_block_client);
-  AddKnownTagsToAdBlockInstance();
-  AddKnownResourcesToAdBlockInstance();
+  AddKnownTagsToAdBlockInstance(ad_block_client.get());
+  AddKnownResourcesToAdBlockInstance(ad_block_client.get());
+  PublishAdBlockClient(std::move(ad_block_client));
+}
+
+void AdBlockBaseService::UpdateAdBlockRules(const std::string& rules) {
+  UpdateAdBlockClient(std::make_unique<adblock::Engine>(rules));
+}
+
+void AdBlockBaseService::ScheduleApplyTagsAndResources() {
+  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
+  // Tags and resources are typically changed several at a time, e.g. when the
+  // embed prefs are read at startup, so only publish once for all of them.
+  if (apply_pending_)
+    return;
+  apply_pending_ = true;
+  GetTaskRunner()->PostTask(
+      FROM_HERE, base::BindOnce(&AdBlockBaseService::ApplyTagsAndResources,
+                                base::Unretained(this)));
+}
+
+void AdBlockBaseService::ApplyTagsAndResources() {
+  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
+  // Publishing a new engine in the meantime already applied the changes.
+  if (!apply_pending_)
+    return;
+
+  // Holding the lock keeps other sequences from taking a reference to the
+  // engine while it changes.
+  base::AutoLock lock(snapshot_lock_);
+  if (!snapshot_->HasOneRef()) {
+    GetTaskRunner()->PostDelayedTask(
+        FROM_HERE,
+        base::BindOnce(&AdBlockBaseService::ApplyTagsAndResources,
+                       base::Unretained(this)),
+        kEngineInUseRetryDelay);
+    return;
+  }
+
+  std::unique_ptr<adblock::Engine> ad_block_client = snapshot_->TakeEngine();
+  for (const auto& tag : engine_tags_) {
+    if (std::find(tags_.begin(), tags_.end(), tag) == tags_.end())
+      ad_block_client->removeTag(tag);
+  }
+  for (const auto& tag : tags_) {
+    if (std::find(engine_tags_.begin(), engine_tags_.end(), tag) ==
+        engine_tags_.end())
+      ad_block_client->addTag(tag);
+  }
+  if (resources_changed_)
+    AddKnownResourcesToAdBlockInstance(ad_block_client.get());
+  // The previous snapshot has no engine left, so it is cheap to release here.
+  PublishAdBlockClientLocked(std::move(ad_block_client));
+}
+
+void AdBlockBaseService::PublishAdBlockClient(
+    std::unique_ptr<adblock::Engine> ad_block_client) {
+  scoped_refptr<AdBlockEngineSnapshot> previous_snapshot;
+  {
+    base::AutoLock lock(snapshot_lock_);
+    previous_snapshot = PublishAdBlockClientLocked(std::move(ad_block_client));
+  }
+  // |previous_snapshot| holds the previous engine, which is destroyed here
+  // unless a request on another sequence is still matching against it.
+}
+
+scoped_refptr<AdBlockEngineSnapshot>
+AdBlockBaseService::PublishAdBlockClientLocked(
+    std::unique_ptr<adblock::Engine> ad_block_client) {
+  DCHECK(GetTaskRunner()->RunsTasksInCurrentSequence());
+  snapshot_lock_.AssertAcquired();
+  engine_tags_ = tags_;
+  resources_changed_ = false;
+  apply_pending_ = false;
+  auto snapshot = base::MakeRefCounted<AdBlockEngineSnapshot>(
+      std::move(ad_block_client), g_engine_generation.GetNext() + 1);
+  snapshot_.swap(snapshot);
+  // Entries from the previous generation can never hit again.
+  decision_cache_.Clear();
+  return snapshot;
 }
 
-void AdBlockBaseService::AddKnownTagsToAdBlockInstance() {
+void AdBlockBaseService::AddKnownTagsToAdBlockInstance(
+    adblock::Engine* ad_block_client) {
   std::for_each(tags_.begin(), tags_.end(),
-                [&](const std::string tag) { ad_block_client_->addTag(tag); });
+                [&](const std::string tag) { ad_block_client->addTag(tag); });
 }
 
-void AdBlockBaseService::AddKnownResourcesToAdBlockInstance() {
-  ad_block_client_->addResources(resources_);
+void AdBlockBaseService::AddKnownResourcesToAdBlockInstance(
+    adblock::Engine* ad_block_client) {
+  if (!resources_.empty())
+    ad_block_client->addResources(resources_);
 }
 
 bool AdBlockBaseService::Init() {
@@ -258,12 +307,10 @@ void AdBlockBaseService::ResetForTest(const std::string& rules,
   // This is temporary until adblock-rust supports incrementally adding
   // filter rules to an existing instance. At which point the hack below
   // will dissapear.
-  ad_block_client_.reset(new adblock::Engine(rules));
-  AddKnownTagsToAdBlockInstance();
   if (!resources.empty()) {
     resources_ = resources;
   }
-  AddKnownResourcesToAdBlockInstance();
+  UpdateAdBlockRules(rules);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
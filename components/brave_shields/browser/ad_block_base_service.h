@@ -14,9 +14,13 @@
 #include <vector>
 
 #include "base/files/file_path.h"
+#include "base/memory/scoped_refptr.h"
 #include "base/memory/weak_ptr.h"
 #include "base/sequence_checker.h"
+#include "base/synchronization/lock.h"
 #include "base/values.h"
+#include "brave/components/brave_shields/browser/ad_block_decision_cache.h"
+#include "brave/components/brave_shields/browser/ad_block_engine_snapshot.h"
 #include "brave/components/brave_shields/browser/base_brave_shields_service.h"
 #include "brave/components/brave_component_updater/browser/dat_file_util.h"
 #include "third_party/blink/public/mojom/loader/resource_load_info.mojom-shared.h"
@@ -34,8 +38,7 @@ namespace brave_shields {
 // checking and init.
 class AdBlockBaseService : public BaseBraveShieldsService {
  public:
-  using GetDATFileDataResult =
-      brave_component_updater::LoadDATFileDataResult<adblock::Engine>;
+  using GetDATFileDataResult = std::unique_ptr<adblock::Engine>;
 
   explicit AdBlockBaseService(BraveComponent::Delegate* delegate);
   ~AdBlockBaseService() override;
@@ -57,25 +60,72 @@ class AdBlockBaseService : public BaseBraveShieldsService {
           const std::vector<std::string>& ids,
           const std::vector<std::string>& exceptions);
 
+  // Returns the most recently published engine. Safe to call from any
+  // sequence; the returned snapshot stays valid for as long as it is held.
+  scoped_refptr<AdBlockEngineSnapshot> GetEngineSnapshot();
+
+  // When true, requests may be matched from any sequence against the engine
+  // snapshots instead of only on the shields task runner.
+  static bool IsParallelMatchingEnabled();
+
  protected:
   friend class ::AdBlockServiceTest;
   bool Init() override;
 
   void GetDATFileData(const base::FilePath& dat_file_path);
-  void AddKnownTagsToAdBlockInstance();
-  void AddKnownResourcesToAdBlockInstance();
+  // Replaces the engine rules with |rules| and publishes a new engine.
+  void UpdateAdBlockRules(const std::string& rules);
   void ResetForTest(const std::string& rules, const std::string& resources);
 
-  std::unique_ptr<adblock::Engine> ad_block_client_;
+  // Matches the request against |snapshots| in order, reusing the decision
+  // cached for the request when it was made by the same snapshots. Whether
+  // it was is returned in |cache_hit|, if not null.
+  bool ShouldStartRequestWithCachedSnapshots(
+      const AdBlockEngineSnapshots& snapshots,
+      const GURL& url,
+      blink::mojom::ResourceType resource_type,
+      const std::string& tab_host,
+      bool* did_match_exception,
+      bool* cancel_request_explicitly,
+      std::string* mock_data_url,
+      bool* cache_hit);
 
  private:
-  void UpdateAdBlockClient(
-      std::unique_ptr<adblock::Engine> ad_block_client);
+  void UpdateAdBlockClient(std::unique_ptr<adblock::Engine> ad_block_client);
   void OnGetDATFileData(GetDATFileDataResult result);
   void OnPreferenceChanges(const std::string& pref_name);
+  void AddKnownTagsToAdBlockInstance(adblock::Engine* ad_block_client);
+  void AddKnownResourcesToAdBlockInstance(adblock::Engine* ad_block_client);
+  // Applies tag and resource changes once the current task is done, so that
+  // any number of them made in one task publish a single engine.
+  void ScheduleApplyTagsAndResources();
+  // Applies the tag and resource changes to the current engine, rather than
+  // building it again, and publishes it as a new snapshot. Waits for requests
+  // still matching against the engine to let go of it first.
+  void ApplyTagsAndResources();
+  // Publishes |ad_block_client|, which must have |tags_| and |resources_|
+  // applied.
+  void PublishAdBlockClient(std::unique_ptr<adblock::Engine> ad_block_client);
+  // Same as PublishAdBlockClient, with |snapshot_lock_| held by the caller.
+  // Returns the previous snapshot, which is best released after the lock.
+  scoped_refptr<AdBlockEngineSnapshot> PublishAdBlockClientLocked(
+      std::unique_ptr<adblock::Engine> ad_block_client);
 
   std::vector<std::string> tags_;
   std::string resources_;
+  // The tags enabled on the current engine, and whether |resources_| changed
+  // since it was published. Both lag behind until the changes are applied.
+  std::vector<std::string> engine_tags_;
+  bool resources_changed_ = false;
+  bool apply_pending_ = false;
+
+  base::Lock snapshot_lock_;
+  scoped_refptr<AdBlockEngineSnapshot> snapshot_;  // Guarded by lock.
+
+  // Decisions for recently seen requests. Any publish bumps the generation,
+  // which invalidates the decisions made by the previous engine.
+  AdBlockDecisionCache decision_cache_;
+
   base::WeakPtrFactory<AdBlockBaseService> weak_factory_;
   DISALLOW_COPY_AND_ASSIGN(AdBlockBaseService);
 };
@@ -0,0 +1,94 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/ad_block_decision_cache.h"
+
+#include <functional>
+#include <utility>
+
+#include "base/hash/hash.h"
+#include "base/strings/string_piece.h"
+
+namespace brave_shields {
+
+namespace {
+
+size_t MakeKey(const GURL& url,
+               blink::mojom::ResourceType resource_type,
+               const std::string& tab_host) {
+  const base::StringPieceHash hash;
+  return base::HashInts64(
+      base::HashInts64(hash(url.spec()), hash(tab_host)),
+      static_cast<uint64_t>(resource_type));
+}
+
+}  // namespace
+
+AdBlockDecision::AdBlockDecision() = default;
+
+AdBlockDecision::AdBlockDecision(const AdBlockDecision& other) = default;
+
+AdBlockDecision::~AdBlockDecision() = default;
+
+AdBlockDecisionCache::Shard::Shard(size_t size) : entries(size) {}
+
+AdBlockDecisionCache::Shard::~Shard() = default;
+
+AdBlockDecisionCache::AdBlockDecisionCache(size_t entries_per_shard) {
+  for (auto& shard : shards_)
+    shard = std::make_unique<Shard>(entries_per_shard);
+}
+
+AdBlockDecisionCache::~AdBlockDecisionCache() = default;
+
+AdBlockDecisionCache::Shard* AdBlockDecisionCache::GetShard(size_t key) {
+  return shards_[key % kShardCount].get();
+}
+
+bool AdBlockDecisionCache::Get(const GURL& url,
+                               blink::mojom::ResourceType resource_type,
+                               const std::string& tab_host,
+                               uint64_t generation,
+                               AdBlockDecision* decision) {
+  const size_t key = MakeKey(url, resource_type, tab_host);
+  Shard* shard = GetShard(key);
+  base::AutoLock lock(shard->lock);
+  auto it = shard->entries.Get(key);
+  if (it == shard->entries.end())
+    return false;
+  if (it->second.decision.generation != generation ||
+      it->second.url_hash != base::PersistentHash(url.spec()) ||
+      it->second.resource_type != resource_type ||
+      it->second.tab_host != tab_host) {
+    shard->entries.Erase(it);
+    return false;
+  }
+  *decision = it->second.decision;
+  return true;
+}
+
+void AdBlockDecisionCache::Put(const GURL& url,
+                               blink::mojom::ResourceType resource_type,
+                               const std::string& tab_host,
+                               const AdBlockDecision& decision) {
+  const size_t key = MakeKey(url, resource_type, tab_host);
+  Entry entry;
+  entry.url_hash = base::PersistentHash(url.spec());
+  entry.resource_type = resource_type;
+  entry.tab_host = tab_host;
+  entry.decision = decision;
+  Shard* shard = GetShard(key);
+  base::AutoLock lock(shard->lock);
+  shard->entries.Put(key, std::move(entry));
+}
+
+void AdBlockDecisionCache::Clear() {
+  for (auto& shard : shards_) {
+    base::AutoLock lock(shard->lock);
+    shard->entries.Clear();
+  }
+}
+
+}  // namespace brave_shields
@@ -0,0 +1,90 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_DECISION_CACHE_H_
+#define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_DECISION_CACHE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <memory>
+#include <string>
+
+#include "base/containers/mru_cache.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "third_party/blink/public/mojom/loader/resource_load_info.mojom-shared.h"
+#include "url/gurl.h"
+
+namespace brave_shields {
+
+// The outcome of matching one request against one adblock engine.
+struct AdBlockDecision {
+  AdBlockDecision();
+  AdBlockDecision(const AdBlockDecision& other);
+  ~AdBlockDecision();
+
+  // Generation of the engine snapshots that produced this decision.
+  uint64_t generation = 0;
+  bool should_start = true;
+  bool did_match_exception = false;
+  bool cancel_request_explicitly = false;
+  std::string mock_data_url;
+};
+
+// A bounded cache of adblock decisions keyed by a hash of (url, tab host,
+// resource type). Entries are split over independently locked shards so
+// lookups from concurrent sequences rarely contend. Decisions made by an older
+// engine generation are treated as misses and dropped.
+class AdBlockDecisionCache {
+ public:
+  static constexpr size_t kShardCount = 16;
+  static constexpr size_t kDefaultEntriesPerShard = 256;
+
+  explicit AdBlockDecisionCache(
+      size_t entries_per_shard = kDefaultEntriesPerShard);
+  ~AdBlockDecisionCache();
+
+  bool Get(const GURL& url,
+           blink::mojom::ResourceType resource_type,
+           const std::string& tab_host,
+           uint64_t generation,
+           AdBlockDecision* decision);
+  void Put(const GURL& url,
+           blink::mojom::ResourceType resource_type,
+           const std::string& tab_host,
+           const AdBlockDecision& decision);
+  void Clear();
+
+ private:
+  struct Entry {
+    // A second, independent hash of the url, along with the rest of the
+    // request, which tells apart the rare requests whose keys collide.
+    uint32_t url_hash = 0;
+    blink::mojom::ResourceType resource_type =
+        blink::mojom::ResourceType::kMainFrame;
+    std::string tab_host;
+    AdBlockDecision decision;
+  };
+
+  struct Shard {
+    explicit Shard(size_t size);
+    ~Shard();
+
+    base::Lock lock;
+    base::HashingMRUCache<size_t, Entry> entries;
+  };
+
+  Shard* GetShard(size_t key);
+
+  std::array<std::unique_ptr<Shard>, kShardCount> shards_;
+
+  DISALLOW_COPY_AND_ASSIGN(AdBlockDecisionCache);
+};
+
+}  // namespace brave_shields
+
+#endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_DECISION_CACHE_H_
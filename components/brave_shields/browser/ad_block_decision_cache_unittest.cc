@@ -0,0 +1,64 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/ad_block_decision_cache.h"
+
+#include <string>
+
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace brave_shields {
+
+TEST(AdBlockDecisionCacheTest, Operations) {
+  AdBlockDecisionCache cache;
+  const GURL url("https://tracker.example/pixel.gif");
+
+  AdBlockDecision decision;
+  decision.generation = 1;
+  decision.should_start = false;
+  decision.cancel_request_explicitly = true;
+  decision.mock_data_url = "data:image/gif;base64,";
+  cache.Put(url, blink::mojom::ResourceType::kImage, "brave.com", decision);
+
+  AdBlockDecision cached;
+  ASSERT_TRUE(cache.Get(url, blink::mojom::ResourceType::kImage, "brave.com",
+                        1, &cached));
+  EXPECT_FALSE(cached.should_start);
+  EXPECT_TRUE(cached.cancel_request_explicitly);
+  EXPECT_EQ(decision.mock_data_url, cached.mock_data_url);
+
+  // Resource type and tab host are part of the key.
+  EXPECT_FALSE(cache.Get(url, blink::mojom::ResourceType::kScript,
+                         "brave.com", 1, &cached));
+  EXPECT_FALSE(cache.Get(url, blink::mojom::ResourceType::kImage,
+                         "example.com", 1, &cached));
+
+  // A newer engine generation invalidates the entry.
+  EXPECT_FALSE(cache.Get(url, blink::mojom::ResourceType::kImage, "brave.com",
+                         2, &cached));
+  EXPECT_FALSE(cache.Get(url, blink::mojom::ResourceType::kImage, "brave.com",
+                         1, &cached));
+}
+
+TEST(AdBlockDecisionCacheTest, IsBounded) {
+  AdBlockDecisionCache cache(1);
+  AdBlockDecision decision;
+  for (int i = 0; i < 100; ++i) {
+    cache.Put(GURL("https://a" + std::to_string(i) + ".example/"),
+              blink::mojom::ResourceType::kScript, "brave.com", decision);
+  }
+  int hits = 0;
+  AdBlockDecision cached;
+  for (int i = 0; i < 100; ++i) {
+    if (cache.Get(GURL("https://a" + std::to_string(i) + ".example/"),
+                  blink::mojom::ResourceType::kScript, "brave.com", 0,
+                  &cached)) {
+      hits++;
+    }
+  }
+  EXPECT_LE(hits, static_cast<int>(AdBlockDecisionCache::kShardCount));
+}
+
+}  // namespace brave_shields
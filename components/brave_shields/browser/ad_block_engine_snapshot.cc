@@ -0,0 +1,160 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/ad_block_engine_snapshot.h"
+
+#include <utility>
+
+#include "base/logging.h"
+#include "brave/vendor/adblock_rust_ffi/src/wrapper.hpp"
+#include "net/base/registry_controlled_domains/registry_controlled_domain.h"
+#include "url/origin.h"
+
+using namespace net::registry_controlled_domains;  // NOLINT
+
+namespace brave_shields {
+
+std::string ResourceTypeToString(blink::mojom::ResourceType resource_type) {
+  std::string filter_option = "";
+  switch (resource_type) {
+    // top level page
+    case blink::mojom::ResourceType::kMainFrame:
+      filter_option = "main_frame";
+      break;
+    // frame or iframe
+    case blink::mojom::ResourceType::kSubFrame:
+      filter_option = "sub_frame";
+      break;
+    // a CSS stylesheet
+    case blink::mojom::ResourceType::kStylesheet:
+      filter_option = "stylesheet";
+      break;
+    // an external script
+    case blink::mojom::ResourceType::kScript:
+      filter_option = "script";
+      break;
+    // an image (jpg/gif/png/etc)
+    case blink::mojom::ResourceType::kFavicon:
+    case blink::mojom::ResourceType::kImage:
+      filter_option = "image";
+      break;
+    // a font
+    case blink::mojom::ResourceType::kFontResource:
+      filter_option = "font";
+      break;
+    // an "other" subresource.
+    case blink::mojom::ResourceType::kSubResource:
+      filter_option = "other";
+      break;
+    // an object (or embed) tag for a plugin.
+    case blink::mojom::ResourceType::kObject:
+      filter_option = "object";
+      break;
+    // a media resource.
+    case blink::mojom::ResourceType::kMedia:
+      filter_option = "media";
+      break;
+    // a XMLHttpRequest
+    case blink::mojom::ResourceType::kXhr:
+      filter_option = "xhr";
+      break;
+    // a ping request for <a ping>/sendBeacon.
+    case blink::mojom::ResourceType::kPing:
+      filter_option = "ping";
+      break;
+    // the main resource of a dedicated worker.
+    case blink::mojom::ResourceType::kWorker:
+    // the main resource of a shared worker.
+    case blink::mojom::ResourceType::kSharedWorker:
+    // an explicitly requested prefetch
+    case blink::mojom::ResourceType::kPrefetch:
+    // the main resource of a service worker.
+    case blink::mojom::ResourceType::kServiceWorker:
+    // a report of Content Security Policy violations.
+    case blink::mojom::ResourceType::kCspReport:
+    // a resource that a plugin requested.
+    case blink::mojom::ResourceType::kPluginResource:
+    default:
+      break;
+  }
+  return filter_option;
+}
+
+AdBlockEngineSnapshot::AdBlockEngineSnapshot(
+    std::unique_ptr<adblock::Engine> engine,
+    uint64_t generation)
+    : engine_(std::move(engine)), generation_(generation) {
+  DCHECK(engine_);
+}
+
+AdBlockEngineSnapshot::~AdBlockEngineSnapshot() = default;
+
+std::unique_ptr<adblock::Engine> AdBlockEngineSnapshot::TakeEngine() {
+  DCHECK(HasOneRef());
+  DCHECK(engine_);
+  return std::move(engine_);
+}
+
+bool AdBlockEngineSnapshot::ShouldStartRequest(
+    const GURL& url,
+    blink::mojom::ResourceType resource_type,
+    const std::string& tab_host,
+    bool* did_match_exception,
+    bool* cancel_request_explicitly,
+    std::string* mock_data_url) const {
+  // Determine third-party here so the library doesn't need to figure it out.
+  // CreateFromNormalizedTuple is needed because SameDomainOrHost needs
+  // a URL or origin and not a string to a host name.
+  bool is_third_party = !SameDomainOrHost(
+      url,
+      url::Origin::CreateFromNormalizedTuple("https", tab_host.c_str(), 80),
+      INCLUDE_PRIVATE_REGISTRIES);
+  bool explicit_cancel;
+  bool saved_from_exception;
+  if (engine_->matches(
+          url.spec(), url.host(), tab_host, is_third_party,
+          ResourceTypeToString(resource_type), &explicit_cancel,
+          &saved_from_exception, mock_data_url)) {
+    if (cancel_request_explicitly) {
+      *cancel_request_explicitly = explicit_cancel;
+    }
+    // We'd only possibly match an exception filter if we're returning true.
+    if (did_match_exception) {
+      *did_match_exception = false;
+    }
+    return false;
+  }
+
+  if (did_match_exception) {
+    *did_match_exception = saved_from_exception;
+  }
+
+  return true;
+}
+
+bool ShouldStartRequestWithSnapshots(const AdBlockEngineSnapshots& snapshots,
+                                     const GURL& url,
+                                     blink::mojom::ResourceType resource_type,
+                                     const std::string& tab_host,
+                                     bool* did_match_exception,
+                                     bool* cancel_request_explicitly,
+                                     std::string* mock_data_url) {
+  for (const auto& snapshot : snapshots) {
+    if (!snapshot)
+      continue;
+    if (!snapshot->ShouldStartRequest(url, resource_type, tab_host,
+                                      did_match_exception,
+                                      cancel_request_explicitly,
+                                      mock_data_url)) {
+      return false;
+    }
+    if (did_match_exception && *did_match_exception) {
+      return true;
+    }
+  }
+  return true;
+}
+
+}  // namespace brave_shields
@@ -0,0 +1,85 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_ENGINE_SNAPSHOT_H_
+#define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_ENGINE_SNAPSHOT_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "third_party/blink/public/mojom/loader/resource_load_info.mojom-shared.h"
+#include "url/gurl.h"
+
+namespace adblock {
+class Engine;
+}
+
+namespace brave_shields {
+
+// An immutable, ref-counted view of a fully configured adblock engine (rules,
+// tags and resources applied). Once published by an AdBlockBaseService a
+// snapshot is never modified again; any change to the engine produces a new
+// snapshot instead, which takes over the engine of the previous one once
+// nothing else refers to it. This lets requests be matched from any sequence
+// while the owning service keeps updating its lists.
+class AdBlockEngineSnapshot
+    : public base::RefCountedThreadSafe<AdBlockEngineSnapshot> {
+ public:
+  AdBlockEngineSnapshot(std::unique_ptr<adblock::Engine> engine,
+                        uint64_t generation);
+
+  // Same semantics as BaseBraveShieldsService::ShouldStartRequest.
+  bool ShouldStartRequest(const GURL& url,
+                          blink::mojom::ResourceType resource_type,
+                          const std::string& tab_host,
+                          bool* did_match_exception,
+                          bool* cancel_request_explicitly,
+                          std::string* mock_data_url) const;
+
+  // Monotonically increasing per service, bumped on every publish.
+  uint64_t generation() const { return generation_; }
+
+  // Read-only access for cosmetic filtering queries.
+  adblock::Engine* engine() const { return engine_.get(); }
+
+  // Moves the engine out so that it can be changed and published again as a
+  // new snapshot. The caller must hold the only reference, as the snapshot
+  // can't match requests anymore.
+  std::unique_ptr<adblock::Engine> TakeEngine();
+
+ private:
+  friend class base::RefCountedThreadSafe<AdBlockEngineSnapshot>;
+  ~AdBlockEngineSnapshot();
+
+  std::unique_ptr<adblock::Engine> engine_;
+  const uint64_t generation_;
+
+  DISALLOW_COPY_AND_ASSIGN(AdBlockEngineSnapshot);
+};
+
+using AdBlockEngineSnapshots =
+    std::vector<scoped_refptr<AdBlockEngineSnapshot>>;
+
+// Evaluates a request against |snapshots| in order, stopping at the first
+// block or exception match, the same way the default, regional and custom
+// filter services are consulted serially.
+bool ShouldStartRequestWithSnapshots(const AdBlockEngineSnapshots& snapshots,
+                                     const GURL& url,
+                                     blink::mojom::ResourceType resource_type,
+                                     const std::string& tab_host,
+                                     bool* did_match_exception,
+                                     bool* cancel_request_explicitly,
+                                     std::string* mock_data_url);
+
+std::string ResourceTypeToString(blink::mojom::ResourceType resource_type);
+
+}  // namespace brave_shields
+
+#endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_AD_BLOCK_ENGINE_SNAPSHOT_H_
@@ -0,0 +1,159 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/synchronization/lock.h"
+#include "base/task/post_task.h"
+#include "base/task/thread_pool.h"
+#include "base/test/task_environment.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "brave/components/brave_shields/browser/ad_block_engine_snapshot.h"
+#include "brave/vendor/adblock_rust_ffi/src/wrapper.hpp"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace brave_shields {
+
+namespace {
+
+scoped_refptr<AdBlockEngineSnapshot> MakeSnapshot(const std::string& rules) {
+  return base::MakeRefCounted<AdBlockEngineSnapshot>(
+      std::make_unique<adblock::Engine>(rules), 1);
+}
+
+// Loads the same pages through |task_runner| and returns the sorted times from
+// posting every page to each page having all of its requests decided.
+std::vector<base::TimeDelta> MatchPages(
+    base::test::TaskEnvironment* task_environment,
+    scoped_refptr<base::TaskRunner> task_runner,
+    const AdBlockEngineSnapshots& snapshots,
+    int pages,
+    int requests_per_page,
+    int* blocked) {
+  base::Lock lock;
+  std::vector<base::TimeDelta> latencies;
+  const base::TimeTicks start = base::TimeTicks::Now();
+  for (int page = 0; page < pages; ++page) {
+    task_runner->PostTask(
+        FROM_HERE,
+        base::BindOnce(
+            [](const AdBlockEngineSnapshots& snapshots, int page,
+               int requests_per_page, base::TimeTicks start, base::Lock* lock,
+               std::vector<base::TimeDelta>* latencies, int* blocked) {
+              int page_blocked = 0;
+              for (int i = 0; i < requests_per_page; ++i) {
+                GURL url("https://ads" + std::to_string((page * i) % 4000) +
+                         ".example/r.js");
+                if (!ShouldStartRequestWithSnapshots(
+                        snapshots, url, blink::mojom::ResourceType::kScript,
+                        "brave.com", nullptr, nullptr, nullptr))
+                  page_blocked++;
+              }
+              base::AutoLock auto_lock(*lock);
+              latencies->push_back(base::TimeTicks::Now() - start);
+              *blocked += page_blocked;
+            },
+            snapshots, page, requests_per_page, start, &lock, &latencies,
+            blocked));
+  }
+  task_environment->RunUntilIdle();
+
+  std::sort(latencies.begin(), latencies.end());
+  return latencies;
+}
+
+}  // namespace
+
+TEST(AdBlockEngineSnapshotTest, BlocksMatchingRequest) {
+  auto snapshot = MakeSnapshot("||tracker.example^");
+  bool did_match_exception = false;
+  bool cancel_request_explicitly = false;
+  std::string mock_data_url;
+  EXPECT_FALSE(snapshot->ShouldStartRequest(
+      GURL("https://tracker.example/pixel.gif"),
+      blink::mojom::ResourceType::kImage, "brave.com", &did_match_exception,
+      &cancel_request_explicitly, &mock_data_url));
+  EXPECT_TRUE(snapshot->ShouldStartRequest(
+      GURL("https://cdn.example/app.js"), blink::mojom::ResourceType::kScript,
+      "brave.com", &did_match_exception, &cancel_request_explicitly,
+      &mock_data_url));
+  EXPECT_FALSE(did_match_exception);
+}
+
+TEST(AdBlockEngineSnapshotTest, ExceptionStopsLaterSnapshots) {
+  AdBlockEngineSnapshots snapshots = {
+      MakeSnapshot("||tracker.example^\n@@||tracker.example/allowed^"),
+      MakeSnapshot("||tracker.example^")};
+  bool did_match_exception = false;
+  EXPECT_TRUE(ShouldStartRequestWithSnapshots(
+      snapshots, GURL("https://tracker.example/allowed/a.js"),
+      blink::mojom::ResourceType::kScript, "brave.com", &did_match_exception,
+      nullptr, nullptr));
+  EXPECT_TRUE(did_match_exception);
+
+  EXPECT_FALSE(ShouldStartRequestWithSnapshots(
+      snapshots, GURL("https://tracker.example/b.js"),
+      blink::mojom::ResourceType::kScript, "brave.com", &did_match_exception,
+      nullptr, nullptr));
+}
+
+TEST(AdBlockEngineSnapshotTest, TakeEngineKeepsRules) {
+  auto snapshot = MakeSnapshot("||tracker.example^");
+  std::unique_ptr<adblock::Engine> engine = snapshot->TakeEngine();
+  ASSERT_TRUE(engine);
+  snapshot = base::MakeRefCounted<AdBlockEngineSnapshot>(std::move(engine), 2);
+  EXPECT_EQ(2u, snapshot->generation());
+  EXPECT_FALSE(snapshot->ShouldStartRequest(
+      GURL("https://tracker.example/pixel.gif"),
+      blink::mojom::ResourceType::kImage, "brave.com", nullptr, nullptr,
+      nullptr));
+}
+
+// Loads concurrent pages once on a single sequence, as requests were matched
+// on the shields task runner, and once on the thread pool against the engine
+// snapshots, and reports p50/p99 page latency for both.
+//
+// Disabled by default, as it is a benchmark. Run it with
+// --gtest_also_run_disabled_tests.
+TEST(AdBlockEngineSnapshotTest, DISABLED_ConcurrentMatchingLatency) {
+  base::test::TaskEnvironment task_environment;
+  std::string rules;
+  for (int i = 0; i < 2000; ++i)
+    rules += "||ads" + std::to_string(i) + ".example^\n";
+  AdBlockEngineSnapshots snapshots = {MakeSnapshot(rules), MakeSnapshot(rules),
+                                      MakeSnapshot(rules)};
+
+  // Enough pages for the p99 to be measured rather than be the maximum.
+  constexpr int kPages = 200;
+  constexpr int kRequestsPerPage = 300;
+  int serial_blocked = 0;
+  std::vector<base::TimeDelta> serial = MatchPages(
+      &task_environment,
+      base::ThreadPool::CreateSequencedTaskRunner(
+          {base::TaskPriority::USER_BLOCKING}),
+      snapshots, kPages, kRequestsPerPage, &serial_blocked);
+  int parallel_blocked = 0;
+  std::vector<base::TimeDelta> parallel = MatchPages(
+      &task_environment,
+      base::ThreadPool::CreateTaskRunner({base::TaskPriority::USER_BLOCKING}),
+      snapshots, kPages, kRequestsPerPage, &parallel_blocked);
+
+  ASSERT_EQ(static_cast<size_t>(kPages), serial.size());
+  ASSERT_EQ(static_cast<size_t>(kPages), parallel.size());
+  EXPECT_GT(serial_blocked, 0);
+  EXPECT_EQ(serial_blocked, parallel_blocked);
+  LOG(INFO) << "serial p50: " << serial[kPages / 2]
+            << " p99: " << serial[kPages * 99 / 100]
+            << ", parallel p50: " << parallel[kPages / 2]
+            << " p99: " << parallel[kPages * 99 / 100];
+}
+
+}  // namespace brave_shields
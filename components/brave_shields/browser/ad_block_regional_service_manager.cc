@@ -145,6 +145,16 @@ bool AdBlockRegionalServiceManager::ShouldStartRequest(
   return true;
 }
 
+void AdBlockRegionalServiceManager::GetEngineSnapshots(
+    AdBlockEngineSnapshots* snapshots) {
+  // Only the snapshot references are taken under the lock; matching against
+  // them happens without it.
+  base::AutoLock lock(regional_services_lock_);
+  for (const auto& regional_service : regional_services_) {
+    snapshots->push_back(regional_service.second->GetEngineSnapshot());
+  }
+}
+
 void AdBlockRegionalServiceManager::EnableTag(const std::string& tag,
                                               bool enabled) {
   base::AutoLock lock(regional_services_lock_);
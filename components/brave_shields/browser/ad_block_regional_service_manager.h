@@ -17,6 +17,7 @@
 #include "base/synchronization/lock.h"
 #include "base/values.h"
 #include "brave/components/brave_component_updater/browser/brave_component.h"
+#include "brave/components/brave_shields/browser/ad_block_engine_snapshot.h"
 #include "brave/vendor/adblock_rust_ffi/src/wrapper.hpp"
 #include "third_party/blink/public/mojom/loader/resource_load_info.mojom-shared.h"
 #include "url/gurl.h"
@@ -53,6 +54,8 @@ class AdBlockRegionalServiceManager {
                           bool* matching_exception_filter,
                           bool* cancel_request_explicitly,
                           std::string* mock_data_url);
+  // Appends the engine snapshots of all enabled regional lists.
+  void GetEngineSnapshots(AdBlockEngineSnapshots* snapshots);
   void EnableTag(const std::string& tag, bool enabled);
   void AddResources(const std::string& resources);
   void EnableFilterList(const std::string& uuid, bool enabled);
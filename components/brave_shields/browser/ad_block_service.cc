@@ -14,8 +14,10 @@
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/memory/ptr_util.h"
+#include "base/metrics/histogram_macros.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/task/post_task.h"
 #include "base/threading/thread_restrictions.h"
 #include "brave/browser/brave_browser_process_impl.h"
 #include "brave/common/pref_names.h"
@@ -79,51 +81,37 @@ bool AdBlockService::ShouldStartRequest(
     bool* did_match_exception,
     bool* cancel_request_explicitly,
     std::string* mock_data_url) {
+  DCHECK(IsParallelMatchingEnabled() ||
+         GetTaskRunner()->RunsTasksInCurrentSequence());
+
+  // The default, regional and custom engines are consulted as one, so a
+  // cached decision spares matching against all of them.
+  bool cache_hit = false;
+  bool should_start = ShouldStartRequestWithCachedSnapshots(
+      GetEngineSnapshots(), url, resource_type, tab_host, did_match_exception,
+      cancel_request_explicitly, mock_data_url, &cache_hit);
+  UMA_HISTOGRAM_BOOLEAN("Brave.Shields.AdBlockDecisionCacheHit", cache_hit);
+  return should_start;
+}
 
-  if (!AdBlockBaseService::ShouldStartRequest(
-          url, resource_type, tab_host, did_match_exception,
-          cancel_request_explicitly, mock_data_url)) {
-    return false;
-  }
-  if (did_match_exception && *did_match_exception) {
-    return true;
-  }
-
-  if (!regional_service_manager()->ShouldStartRequest(
-          url, resource_type, tab_host, did_match_exception,
-          cancel_request_explicitly, mock_data_url)) {
-    return false;
-  }
-  if (did_match_exception && *did_match_exception) {
-    return true;
-  }
-
-  if (!custom_filters_service()->ShouldStartRequest(
-        url, resource_type, tab_host, did_match_exception,
-        cancel_request_explicitly, mock_data_url)) {
-    return false;
-  }
-  if (did_match_exception && *did_match_exception) {
-    return true;
-  }
+AdBlockEngineSnapshots AdBlockService::GetEngineSnapshots() {
+  AdBlockEngineSnapshots snapshots;
+  snapshots.push_back(GetEngineSnapshot());
+  regional_service_manager()->GetEngineSnapshots(&snapshots);
+  snapshots.push_back(custom_filters_service()->GetEngineSnapshot());
+  return snapshots;
+}
 
-  return true;
+scoped_refptr<base::TaskRunner> AdBlockService::GetMatchingTaskRunner() {
+  return matching_task_runner_;
 }
 
 AdBlockRegionalServiceManager* AdBlockService::regional_service_manager() {
-  if (!regional_service_manager_)
-    regional_service_manager_ =
-        brave_shields::AdBlockRegionalServiceManagerFactory(
-            component_delegate_);
   return regional_service_manager_.get();
 }
 
 brave_shields::AdBlockCustomFiltersService*
 AdBlockService::custom_filters_service() {
-  if (!custom_filters_service_)
-    custom_filters_service_ =
-        brave_shields::AdBlockCustomFiltersServiceFactory(
-            component_delegate_);
   return custom_filters_service_.get();
 }
 
@@ -131,6 +119,21 @@ AdBlockService::AdBlockService(
     brave_component_updater::BraveComponent::Delegate* delegate)
     : AdBlockBaseService(delegate),
       component_delegate_(delegate) {
+  // Both are created up front rather than on first use, as requests are
+  // matched against them from thread pool threads.
+  regional_service_manager_ =
+      brave_shields::AdBlockRegionalServiceManagerFactory(component_delegate_);
+  custom_filters_service_ =
+      brave_shields::AdBlockCustomFiltersServiceFactory(component_delegate_);
+
+  // Engine snapshots can be matched from any thread, so requests don't need
+  // to be funnelled through the single shields sequence when that's enabled.
+  matching_task_runner_ =
+      IsParallelMatchingEnabled()
+          ? base::CreateTaskRunner(
+                {base::ThreadPool(), base::TaskPriority::USER_BLOCKING,
+                 base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN})
+          : GetTaskRunner();
 }
 
 AdBlockService::~AdBlockService() {}
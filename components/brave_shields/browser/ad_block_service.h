@@ -12,6 +12,8 @@
 #include <string>
 #include <vector>
 
+#include "base/memory/scoped_refptr.h"
+#include "base/task_runner.h"
 #include "brave/components/brave_shields/browser/ad_block_base_service.h"
 #include "components/keyed_service/core/keyed_service.h"
 #include "components/prefs/pref_registry_simple.h"
@@ -53,6 +55,15 @@ class AdBlockService : public AdBlockBaseService {
                           bool* cancel_request_explicitly,
                           std::string* mock_data_url) override;
 
+  // Returns the current default, regional and custom filter engines, in the
+  // order they are consulted. Safe to call from any sequence.
+  AdBlockEngineSnapshots GetEngineSnapshots();
+
+  // Returns the task runner requests are matched on, which is shared by all
+  // requests. With parallel matching it runs tasks on any thread pool thread,
+  // otherwise it's the shields task runner.
+  scoped_refptr<base::TaskRunner> GetMatchingTaskRunner();
+
   AdBlockRegionalServiceManager* regional_service_manager();
   AdBlockCustomFiltersService* custom_filters_service();
 
@@ -79,6 +90,7 @@ class AdBlockService : public AdBlockBaseService {
       custom_filters_service_;
 
   BraveComponent::Delegate* component_delegate_;
+  scoped_refptr<base::TaskRunner> matching_task_runner_;
 
   base::WeakPtrFactory<AdBlockService> weak_factory_{this};
   DISALLOW_COPY_AND_ASSIGN(AdBlockService);
@@ -6,9 +6,14 @@
 #include "brave/components/brave_shields/browser/brave_shields_util.h"
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "base/feature_list.h"
+#include "base/lazy_instance.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/synchronization/lock.h"
+#include "base/task/post_task.h"
 #include "brave/components/brave_perf_predictor/browser/buildflags.h"
 #include "brave/components/brave_shields/browser/brave_shields_p3a.h"
 #include "brave/components/brave_shields/browser/brave_shields_web_contents_observer.h"
@@ -18,6 +23,7 @@
 #include "brave/components/content_settings/core/common/content_settings_util.h"
 #include "components/content_settings/core/browser/host_content_settings_map.h"
 #include "components/content_settings/core/common/pref_names.h"
+#include "content/public/browser/browser_task_traits.h"
 #include "content/public/browser/browser_thread.h"
 #include "content/public/common/referrer.h"
 #include "net/base/registry_controlled_domains/registry_controlled_domain.h"
@@ -33,6 +39,63 @@ namespace brave_shields {
 
 namespace {
 
+struct BlockedEvent {
+  GURL request_url;
+  int render_frame_id;
+  int render_process_id;
+  int frame_tree_node_id;
+  std::string block_type;
+};
+
+// Blocked events dispatched off the UI thread, which are delivered together
+// by a single task posted to the UI thread rather than one task each.
+class PendingBlockedEvents {
+ public:
+  PendingBlockedEvents() = default;
+
+  // Returns true if a task to deliver the events has to be posted.
+  bool Add(BlockedEvent event) {
+    base::AutoLock auto_lock(lock_);
+    events_.push_back(std::move(event));
+    return events_.size() == 1;
+  }
+
+  std::vector<BlockedEvent> Take() {
+    std::vector<BlockedEvent> events;
+    base::AutoLock auto_lock(lock_);
+    events.swap(events_);
+    return events;
+  }
+
+ private:
+  base::Lock lock_;
+  std::vector<BlockedEvent> events_;
+
+  DISALLOW_COPY_AND_ASSIGN(PendingBlockedEvents);
+};
+
+base::LazyInstance<PendingBlockedEvents>::Leaky g_pending_blocked_events =
+    LAZY_INSTANCE_INITIALIZER;
+
+void DispatchBlockedEventOnUI(const BlockedEvent& event) {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  BraveShieldsWebContentsObserver::DispatchBlockedEvent(
+      event.block_type, event.request_url.spec(), event.render_process_id,
+      event.render_frame_id, event.frame_tree_node_id);
+
+#if BUILDFLAG(ENABLE_BRAVE_PERF_PREDICTOR)
+  brave_perf_predictor::PerfPredictorTabHelper::DispatchBlockedEvent(
+      event.request_url.spec(), event.render_process_id,
+      event.render_frame_id, event.frame_tree_node_id);
+#endif
+}
+
+void DispatchPendingBlockedEvents() {
+  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+  for (const auto& event : g_pending_blocked_events.Get().Take())
+    DispatchBlockedEventOnUI(event);
+}
+
 void RecordShieldsToggled(PrefService* local_state) {
   ::brave_shields::MaybeRecordShieldsUsageP3A(::brave_shields::kShutOffShields,
                                               local_state);
@@ -420,16 +483,19 @@ void DispatchBlockedEvent(const GURL& request_url,
                           int render_process_id,
                           int frame_tree_node_id,
                           const std::string& block_type) {
-  DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
-  BraveShieldsWebContentsObserver::DispatchBlockedEvent(
-      block_type, request_url.spec(),
-      render_process_id, render_frame_id, frame_tree_node_id);
+  BlockedEvent event = {request_url, render_frame_id, render_process_id,
+                        frame_tree_node_id, block_type};
+  if (content::BrowserThread::CurrentlyOn(content::BrowserThread::UI)) {
+    // Keep the order with events still waiting to be delivered.
+    DispatchPendingBlockedEvents();
+    DispatchBlockedEventOnUI(event);
+    return;
+  }
 
-#if BUILDFLAG(ENABLE_BRAVE_PERF_PREDICTOR)
-  brave_perf_predictor::PerfPredictorTabHelper::DispatchBlockedEvent(
-      request_url.spec(), render_process_id,
-      render_frame_id, frame_tree_node_id);
-#endif
+  if (g_pending_blocked_events.Get().Add(std::move(event))) {
+    base::PostTask(FROM_HERE, {content::BrowserThread::UI},
+                   base::BindOnce(&DispatchPendingBlockedEvents));
+  }
 }
 
 bool MaybeChangeReferrer(
@@ -87,6 +87,8 @@ void SetNoScriptControlType(HostContentSettingsMap* map,
 ControlType GetNoScriptControlType(HostContentSettingsMap* map,
                                    const GURL& url);
 
+// Can be called from any thread. Events dispatched off the UI thread are
+// delivered in batches.
 void DispatchBlockedEvent(const GURL& request_url,
                           int render_frame_id,
                           int render_process_id,
@@ -0,0 +1,275 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/https_everywhere_rule_index.h"
+
+#include <utility>
+#include <vector>
+
+#include "base/json/json_reader.h"
+#include "base/logging.h"
+#include "base/values.h"
+#include "third_party/leveldatabase/src/include/leveldb/db.h"
+#include "third_party/re2/src/re2/re2.h"
+
+namespace brave_shields {
+
+namespace {
+
+const char kWildcardLabel[] = "*";
+
+// HTTPS Everywhere rules use $1-style back references, RE2 wants \1.
+std::string CorrecttoRuleToRE2Engine(const std::string& to) {
+  std::string correctedto(to);
+  size_t pos = correctedto.find('$');
+  while (std::string::npos != pos) {
+    correctedto[pos] = '\\';
+    pos = correctedto.find('$', pos + 1);
+  }
+  return correctedto;
+}
+
+// Returns the last label of |*host| and strips it, including the dot.
+base::StringPiece PopLastLabel(base::StringPiece* host) {
+  size_t dot = host->rfind('.');
+  if (dot == base::StringPiece::npos) {
+    base::StringPiece label = *host;
+    *host = base::StringPiece();
+    return label;
+  }
+  base::StringPiece label = host->substr(dot + 1);
+  *host = host->substr(0, dot);
+  return label;
+}
+
+}  // namespace
+
+HTTPSEverywhereRuleIndex::Rule::Rule() = default;
+HTTPSEverywhereRuleIndex::Rule::Rule(Rule&& other) = default;
+HTTPSEverywhereRuleIndex::Rule::~Rule() = default;
+
+HTTPSEverywhereRuleIndex::RuleGroup::RuleGroup() = default;
+HTTPSEverywhereRuleIndex::RuleGroup::RuleGroup(RuleGroup&& other) = default;
+HTTPSEverywhereRuleIndex::RuleGroup::~RuleGroup() = default;
+
+HTTPSEverywhereRuleIndex::RuleSet::RuleSet() = default;
+HTTPSEverywhereRuleIndex::RuleSet::~RuleSet() = default;
+
+HTTPSEverywhereRuleIndex::Node::Node() = default;
+HTTPSEverywhereRuleIndex::Node::~Node() = default;
+
+// static
+const size_t HTTPSEverywhereRuleIndex::kMaxCompiledRuleSets = 500;
+
+HTTPSEverywhereRuleIndex::HTTPSEverywhereRuleIndex(
+    std::unique_ptr<leveldb::DB> db)
+    : db_(std::move(db)), compiled_rule_sets_(kMaxCompiledRuleSets) {}
+
+HTTPSEverywhereRuleIndex::~HTTPSEverywhereRuleIndex() = default;
+
+// static
+std::unique_ptr<HTTPSEverywhereRuleIndex>
+HTTPSEverywhereRuleIndex::CreateFromLevelDB(std::unique_ptr<leveldb::DB> db) {
+  if (!db)
+    return nullptr;
+
+  std::unique_ptr<leveldb::Iterator> it(
+      db->NewIterator(leveldb::ReadOptions()));
+  auto index = std::make_unique<HTTPSEverywhereRuleIndex>(std::move(db));
+  for (it->SeekToFirst(); it->Valid(); it->Next())
+    index->AddKey(base::StringPiece(it->key().data(), it->key().size()));
+  leveldb::Status status = it->status();
+  // The iterator has to go before the database it reads from.
+  it.reset();
+  if (!status.ok()) {
+    LOG(ERROR) << "Failed to read HTTPS Everywhere rulesets: "
+               << status.ToString();
+    return nullptr;
+  }
+  return index;
+}
+
+void HTTPSEverywhereRuleIndex::AddKey(base::StringPiece key) {
+  Node* node = &root_;
+  bool wildcard = false;
+  size_t start = 0;
+  while (start <= key.size()) {
+    size_t dot = key.find('.', start);
+    if (dot == base::StringPiece::npos)
+      dot = key.size();
+    base::StringPiece label = key.substr(start, dot - start);
+    start = dot + 1;
+    if (label == kWildcardLabel && start > key.size()) {
+      wildcard = true;
+      break;
+    }
+    auto child = node->children.find(label);
+    if (child == node->children.end()) {
+      child = node->children
+                  .emplace(label.as_string(), std::make_unique<Node>())
+                  .first;
+    }
+    node = child->second.get();
+  }
+
+  bool& has_rule_set = wildcard ? node->has_wildcard : node->has_exact;
+  if (!has_rule_set)
+    size_++;
+  has_rule_set = true;
+}
+
+std::string HTTPSEverywhereRuleIndex::GetHTTPSURL(base::StringPiece host,
+                                                  const std::string& url) {
+  for (const auto& key : GetRuleSetKeys(host)) {
+    std::string new_url = Apply(*GetRuleSet(key), url);
+    if (!new_url.empty())
+      return new_url;
+  }
+  return std::string();
+}
+
+bool HTTPSEverywhereRuleIndex::HasRuleSetsForHost(
+    base::StringPiece host) const {
+  return !GetRuleSetKeys(host).empty();
+}
+
+std::vector<std::string> HTTPSEverywhereRuleIndex::GetRuleSetKeys(
+    base::StringPiece host) const {
+  std::vector<std::string> keys;
+  // The matched nodes and the length of |key| at each of them, where |key|
+  // is the reversed host up to that node, e.g. "com.example".
+  std::vector<std::pair<const Node*, size_t>> path;
+  // Host labels nest at most a few levels deep in practice.
+  path.reserve(8);
+  std::string key;
+  key.reserve(host.size() + 2);
+  const Node* node = &root_;
+  while (!host.empty()) {
+    base::StringPiece label = PopLastLabel(&host);
+    auto child = node->children.find(label);
+    if (child == node->children.end())
+      break;
+    if (!key.empty())
+      key.push_back('.');
+    label.AppendToString(&key);
+    node = child->second.get();
+    path.emplace_back(node, key.size());
+  }
+  if (path.empty())
+    return keys;
+  const bool matched_full_host = host.empty();
+
+  // The exact host, e.g. com.example.www.
+  if (matched_full_host && path.size() >= 2 && path.back().first->has_exact)
+    keys.push_back(key);
+
+  // Then com.example.*, but neither com.example.www.* nor com.*.
+  for (size_t depth = matched_full_host ? path.size() - 1 : path.size();
+       depth >= 2; --depth) {
+    if (!path[depth - 1].first->has_wildcard)
+      continue;
+    key.resize(path[depth - 1].second);
+    key.append(".*");
+    keys.push_back(key);
+  }
+  return keys;
+}
+
+const HTTPSEverywhereRuleIndex::RuleSet* HTTPSEverywhereRuleIndex::GetRuleSet(
+    const std::string& key) {
+  auto it = compiled_rule_sets_.Get(key);
+  if (it != compiled_rule_sets_.end())
+    return it->second.get();
+
+  std::string json;
+  leveldb::Status status = db_->Get(leveldb::ReadOptions(), key, &json);
+  if (!status.ok()) {
+    LOG(ERROR) << "Failed to read HTTPS Everywhere ruleset " << key << ": "
+               << status.ToString();
+  }
+  // A ruleset that fails to read or parse is cached empty, so it is not
+  // retried on every request.
+  return compiled_rule_sets_.Put(key, Compile(json))->second.get();
+}
+
+// static
+std::unique_ptr<HTTPSEverywhereRuleIndex::RuleSet>
+HTTPSEverywhereRuleIndex::Compile(const std::string& json) {
+  auto rule_set = std::make_unique<RuleSet>();
+  base::Optional<base::Value> json_object = base::JSONReader::Read(json);
+  if (!json_object || !json_object->is_list())
+    return rule_set;
+
+  for (const auto& group_value : json_object->GetList()) {
+    if (!group_value.is_dict())
+      continue;
+
+    RuleGroup group;
+    const base::Value* exclusions = group_value.FindListKey("e");
+    if (exclusions) {
+      for (const auto& exclusion : exclusions->GetList()) {
+        if (!exclusion.is_dict())
+          continue;
+        const std::string* pattern = exclusion.FindStringKey("p");
+        if (!pattern)
+          continue;
+        group.exclusions.push_back(
+            std::make_unique<re2::RE2>(CorrecttoRuleToRE2Engine(*pattern)));
+      }
+    }
+
+    const base::Value* rules = group_value.FindListKey("r");
+    group.has_rules = rules;
+    if (rules) {
+      for (const auto& rule_value : rules->GetList()) {
+        if (!rule_value.is_dict())
+          continue;
+        Rule rule;
+        if (rule_value.FindKey("d")) {
+          rule.upgrade_scheme = true;
+          group.rules.push_back(std::move(rule));
+          continue;
+        }
+        const std::string* from = rule_value.FindStringKey("f");
+        const std::string* to = rule_value.FindStringKey("t");
+        if (!from || !to)
+          continue;
+        rule.from = std::make_unique<re2::RE2>(*from);
+        rule.to = CorrecttoRuleToRE2Engine(*to);
+        group.rules.push_back(std::move(rule));
+      }
+    }
+    rule_set->groups.push_back(std::move(group));
+  }
+  return rule_set;
+}
+
+// static
+std::string HTTPSEverywhereRuleIndex::Apply(const RuleSet& rule_set,
+                                            const std::string& url) {
+  for (const auto& group : rule_set.groups) {
+    for (const auto& exclusion : group.exclusions) {
+      if (re2::RE2::FullMatch(url, *exclusion))
+        return std::string();
+    }
+    if (!group.has_rules)
+      return std::string();
+
+    for (const auto& rule : group.rules) {
+      if (rule.upgrade_scheme) {
+        std::string new_url(url);
+        return new_url.insert(4, "s");
+      }
+      std::string new_url(url);
+      if (re2::RE2::Replace(&new_url, *rule.from, rule.to) &&
+          new_url != url) {
+        return new_url;
+      }
+    }
+  }
+  return std::string();
+}
+
+}  // namespace brave_shields
@@ -0,0 +1,129 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_RULE_INDEX_H_
+#define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_RULE_INDEX_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/containers/mru_cache.h"
+#include "base/macros.h"
+#include "base/strings/string_piece.h"
+
+namespace leveldb {
+class DB;
+}
+
+namespace re2 {
+class RE2;
+}
+
+namespace brave_shields {
+
+// Index over the HTTPS Everywhere rulesets, built once per component update.
+// Only the ruleset keys are held in memory, in a trie keyed by reversed host
+// labels (com -> example -> www), so a lookup walks the request host once and
+// only reads the database for the keys that actually exist, instead of
+// issuing one leveldb read per parent domain.
+//
+// The ruleset JSON stays in leveldb. A ruleset is read and its regular
+// expressions compiled when it is first matched, and the compiled form is
+// kept in a bounded MRU cache, so the hosts a profile visits often do no
+// reading, parsing or RE2 compilation while memory stays capped.
+class HTTPSEverywhereRuleIndex {
+ public:
+  // The most compiled rulesets kept at once.
+  static const size_t kMaxCompiledRuleSets;
+
+  explicit HTTPSEverywhereRuleIndex(std::unique_ptr<leveldb::DB> db);
+  ~HTTPSEverywhereRuleIndex();
+
+  // Builds an index over every ruleset key in |db|, which the index takes
+  // ownership of. Returns nullptr on failure.
+  static std::unique_ptr<HTTPSEverywhereRuleIndex> CreateFromLevelDB(
+      std::unique_ptr<leveldb::DB> db);
+
+  // Returns the HTTPS rewrite of |url| for |host|, or an empty string when no
+  // ruleset applies. Lookup order matches the leveldb path: the exact host
+  // first, then wildcards from the most to the least specific parent domain,
+  // never the bare TLD.
+  std::string GetHTTPSURL(base::StringPiece host, const std::string& url);
+
+  // Returns whether any ruleset could apply to |host|. Only the in-memory
+  // index is read, so this is safe to call from any sequence while the index
+  // is alive.
+  bool HasRuleSetsForHost(base::StringPiece host) const;
+
+  // The number of rulesets in the index.
+  size_t size() const { return size_; }
+  // The number of rulesets currently held compiled.
+  size_t compiled_size() const { return compiled_rule_sets_.size(); }
+
+ private:
+  struct Rule {
+    Rule();
+    Rule(Rule&& other);
+    ~Rule();
+
+    // Rules carrying "d" just upgrade the scheme.
+    bool upgrade_scheme = false;
+    std::unique_ptr<re2::RE2> from;
+    std::string to;
+  };
+
+  struct RuleGroup {
+    RuleGroup();
+    RuleGroup(RuleGroup&& other);
+    ~RuleGroup();
+
+    std::vector<std::unique_ptr<re2::RE2>> exclusions;
+    std::vector<Rule> rules;
+    // The leveldb path stops at the first group without a rule list.
+    bool has_rules = false;
+  };
+
+  struct RuleSet {
+    RuleSet();
+    ~RuleSet();
+
+    std::vector<RuleGroup> groups;
+  };
+
+  struct Node {
+    Node();
+    ~Node();
+
+    std::map<std::string, std::unique_ptr<Node>, std::less<>> children;
+    bool has_exact = false;
+    bool has_wildcard = false;
+  };
+
+  // Returns the keys of the rulesets for |host|, in lookup order.
+  std::vector<std::string> GetRuleSetKeys(base::StringPiece host) const;
+
+  // Adds |key|, in the database's reversed format, e.g. "com.example.www" or
+  // "com.example.*".
+  void AddKey(base::StringPiece key);
+  // Returns the compiled ruleset for |key|, reading it from the database when
+  // it isn't cached. Never returns null.
+  const RuleSet* GetRuleSet(const std::string& key);
+
+  static std::unique_ptr<RuleSet> Compile(const std::string& json);
+  static std::string Apply(const RuleSet& rule_set, const std::string& url);
+
+  std::unique_ptr<leveldb::DB> db_;
+  Node root_;
+  size_t size_ = 0;
+  base::MRUCache<std::string, std::unique_ptr<RuleSet>> compiled_rule_sets_;
+
+  DISALLOW_COPY_AND_ASSIGN(HTTPSEverywhereRuleIndex);
+};
+
+}  // namespace brave_shields
+
+#endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_HTTPS_EVERYWHERE_RULE_INDEX_H_
@@ -0,0 +1,216 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/https_everywhere_rule_index.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/json/json_reader.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/time/time.h"
+#include "base/timer/elapsed_timer.h"
+#include "base/values.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/leveldatabase/leveldb_chrome.h"
+#include "third_party/leveldatabase/src/include/leveldb/db.h"
+
+namespace brave_shields {
+
+namespace {
+
+const char kUpgradeRule[] = R"([{"r": [{"d": 1}]}])";
+
+// The lookup the service did before the index: one leveldb read per
+// candidate key, and a JSON parse of every ruleset found.
+std::string GetHTTPSURLFromLevelDB(leveldb::DB* db,
+                                   const std::string& host,
+                                   const std::string& url) {
+  std::vector<std::string> labels = base::SplitString(
+      host, ".", base::KEEP_WHITESPACE, base::SPLIT_WANT_ALL);
+  for (size_t i = 0; i + 1 < labels.size(); ++i) {
+    std::string key;
+    for (size_t j = labels.size(); j > i; --j) {
+      if (!key.empty())
+        key += ".";
+      key += labels[j - 1];
+    }
+    if (i != 0)
+      key += ".*";
+    std::string json;
+    if (!db->Get(leveldb::ReadOptions(), key, &json).ok())
+      continue;
+    base::Optional<base::Value> rules = base::JSONReader::Read(json);
+    if (rules && rules->is_list()) {
+      std::string new_url(url);
+      return new_url.insert(4, "s");
+    }
+  }
+  return std::string();
+}
+
+}  // namespace
+
+class HTTPSEverywhereRuleIndexTest : public testing::Test {
+ public:
+  HTTPSEverywhereRuleIndexTest()
+      : env_(leveldb_chrome::NewMemEnv("HTTPSEverywhereRuleIndexTest")) {}
+
+ protected:
+  std::unique_ptr<leveldb::DB> CreateDB(
+      const std::vector<std::pair<std::string, std::string>>& rule_sets) {
+    leveldb::Options options;
+    options.env = env_.get();
+    options.create_if_missing = true;
+    leveldb::DB* db = nullptr;
+    EXPECT_TRUE(leveldb::DB::Open(options, "httpse", &db).ok());
+    for (const auto& rule_set : rule_sets) {
+      EXPECT_TRUE(db->Put(leveldb::WriteOptions(), rule_set.first,
+                          rule_set.second).ok());
+    }
+    return std::unique_ptr<leveldb::DB>(db);
+  }
+
+  std::unique_ptr<HTTPSEverywhereRuleIndex> CreateIndex(
+      const std::vector<std::pair<std::string, std::string>>& rule_sets) {
+    return HTTPSEverywhereRuleIndex::CreateFromLevelDB(CreateDB(rule_sets));
+  }
+
+  std::unique_ptr<leveldb::Env> env_;
+};
+
+TEST_F(HTTPSEverywhereRuleIndexTest, ExactHostAndWildcards) {
+  auto index = CreateIndex(
+      {{"com.example.www", kUpgradeRule}, {"org.example.*", kUpgradeRule}});
+  ASSERT_TRUE(index);
+  EXPECT_EQ(2u, index->size());
+  // Nothing is read or compiled until it is matched.
+  EXPECT_EQ(0u, index->compiled_size());
+
+  EXPECT_EQ("https://www.example.com/",
+            index->GetHTTPSURL("www.example.com", "http://www.example.com/"));
+  EXPECT_EQ("", index->GetHTTPSURL("example.com", "http://example.com/"));
+  EXPECT_EQ("https://a.b.example.org/",
+            index->GetHTTPSURL("a.b.example.org", "http://a.b.example.org/"));
+  // A wildcard doesn't cover the domain itself.
+  EXPECT_EQ("", index->GetHTTPSURL("example.org", "http://example.org/"));
+  EXPECT_EQ("", index->GetHTTPSURL("brave.com", "http://brave.com/"));
+  EXPECT_EQ(2u, index->compiled_size());
+}
+
+TEST_F(HTTPSEverywhereRuleIndexTest, NeverMatchesBareTLD) {
+  auto index = CreateIndex({{"com.*", kUpgradeRule}});
+  ASSERT_TRUE(index);
+  EXPECT_EQ("", index->GetHTTPSURL("www.example.com",
+                                   "http://www.example.com/"));
+}
+
+TEST_F(HTTPSEverywhereRuleIndexTest, HasRuleSetsForHost) {
+  auto index = CreateIndex(
+      {{"com.example.www", kUpgradeRule}, {"org.example.*", kUpgradeRule}});
+  ASSERT_TRUE(index);
+
+  EXPECT_TRUE(index->HasRuleSetsForHost("www.example.com"));
+  EXPECT_TRUE(index->HasRuleSetsForHost("a.b.example.org"));
+  EXPECT_FALSE(index->HasRuleSetsForHost("example.com"));
+  EXPECT_FALSE(index->HasRuleSetsForHost("example.org"));
+  EXPECT_FALSE(index->HasRuleSetsForHost("brave.com"));
+  // Answered from the index alone.
+  EXPECT_EQ(0u, index->compiled_size());
+}
+
+TEST_F(HTTPSEverywhereRuleIndexTest, RewriteRulesAndExclusions) {
+  auto index = CreateIndex(
+      {{"com.example.*",
+        R"([{"e": [{"p": "^http://login\\.example\\.com/"}],)"
+        R"(   "r": [{"f": "^http://(\\w+)\\.example\\.com/",)"
+        R"(          "t": "https://$1.example.com/"}]}])"}});
+  ASSERT_TRUE(index);
+
+  EXPECT_EQ("https://cdn.example.com/a.js",
+            index->GetHTTPSURL("cdn.example.com",
+                               "http://cdn.example.com/a.js"));
+  EXPECT_EQ("", index->GetHTTPSURL("login.example.com",
+                                   "http://login.example.com/"));
+  // Compiled rules are reused for later lookups.
+  EXPECT_EQ("https://img.example.com/",
+            index->GetHTTPSURL("img.example.com", "http://img.example.com/"));
+  EXPECT_EQ(1u, index->compiled_size());
+}
+
+TEST_F(HTTPSEverywhereRuleIndexTest, CompiledRuleSetsAreBounded) {
+  const size_t kRuleSets = 2 * HTTPSEverywhereRuleIndex::kMaxCompiledRuleSets;
+  std::vector<std::pair<std::string, std::string>> rule_sets;
+  for (size_t i = 0; i < kRuleSets; ++i) {
+    rule_sets.emplace_back("com.site" + base::NumberToString(i) + ".*",
+                           kUpgradeRule);
+  }
+  auto index = CreateIndex(rule_sets);
+  ASSERT_TRUE(index);
+
+  for (size_t i = 0; i < kRuleSets; ++i) {
+    const std::string host = "www.site" + base::NumberToString(i) + ".com";
+    EXPECT_EQ("https://" + host + "/",
+              index->GetHTTPSURL(host, "http://" + host + "/"));
+  }
+  EXPECT_EQ(HTTPSEverywhereRuleIndex::kMaxCompiledRuleSets,
+            index->compiled_size());
+
+  // Evicted rulesets are read back from the database.
+  EXPECT_EQ("https://www.site0.com/",
+            index->GetHTTPSURL("www.site0.com", "http://www.site0.com/"));
+}
+
+// Compares the index against the per-domain leveldb reads it replaced, over a
+// catalog the size of the real one and a working set larger than the
+// compiled-ruleset cache.
+//
+// Disabled by default, as it is a benchmark. Run it with
+// --gtest_also_run_disabled_tests.
+TEST_F(HTTPSEverywhereRuleIndexTest, DISABLED_LookupThroughput) {
+  std::vector<std::pair<std::string, std::string>> rule_sets;
+  for (int i = 0; i < 25000; ++i) {
+    rule_sets.emplace_back("com.site" + base::NumberToString(i) + ".*",
+                           kUpgradeRule);
+  }
+  std::unique_ptr<leveldb::DB> db = CreateDB(rule_sets);
+  std::vector<std::string> hosts;
+  for (int i = 0; i < 100000; ++i)
+    hosts.push_back("www.site" + base::NumberToString(i % 2000) + ".com");
+
+  int leveldb_upgraded = 0;
+  base::ElapsedTimer leveldb_timer;
+  for (const auto& host : hosts) {
+    if (!GetHTTPSURLFromLevelDB(db.get(), host, "http://" + host + "/")
+             .empty()) {
+      leveldb_upgraded++;
+    }
+  }
+  const base::TimeDelta leveldb_elapsed = leveldb_timer.Elapsed();
+
+  auto index = HTTPSEverywhereRuleIndex::CreateFromLevelDB(std::move(db));
+  ASSERT_TRUE(index);
+  int index_upgraded = 0;
+  base::ElapsedTimer index_timer;
+  for (const auto& host : hosts) {
+    if (!index->GetHTTPSURL(host, "http://" + host + "/").empty())
+      index_upgraded++;
+  }
+  const base::TimeDelta index_elapsed = index_timer.Elapsed();
+
+  EXPECT_EQ(leveldb_upgraded, index_upgraded);
+  EXPECT_EQ(static_cast<int>(hosts.size()), index_upgraded);
+  EXPECT_LE(index->compiled_size(),
+            HTTPSEverywhereRuleIndex::kMaxCompiledRuleSets);
+  LOG(INFO) << hosts.size() << " lookups, leveldb: " << leveldb_elapsed
+            << ", index: " << index_elapsed << ", compiled rulesets held: "
+            << index->compiled_size();
+}
+
+}  // namespace brave_shields
@@ -16,10 +16,7 @@
 #include "base/synchronization/lock.h"
 #include "brave/components/brave_shields/browser/base_brave_shields_service.h"
 #include "brave/components/brave_shields/browser/https_everywhere_recently_used_cache.h"
-
-namespace leveldb {
-class DB;
-}
+#include "brave/components/brave_shields/browser/https_everywhere_rule_index.h"
 
 class HTTPSEverywhereServiceTest;
 
@@ -63,9 +60,6 @@ class HTTPSEverywhereService : public BaseBraveShieldsService,
 
   void AddHTTPSEUrlToRedirectList(const uint64_t& request_id);
   bool ShouldHTTPSERedirect(const uint64_t& request_id);
-  std::string ApplyHTTPSRule(const std::string& originalUrl,
-      const std::string& rule);
-  std::string CorrecttoRuleToRE2Engine(const std::string& to);
 
  private:
   friend class ::HTTPSEverywhereServiceTest;
@@ -77,14 +71,15 @@ class HTTPSEverywhereService : public BaseBraveShieldsService,
       const std::string& component_id,
       const std::string& component_base64_public_key);
 
-  void CloseDatabase();
-
   void InitDB(const base::FilePath& install_dir);
 
   base::Lock httpse_get_urls_redirects_count_mutex_;
   std::vector<HTTPSE_REDIRECTS_COUNT_ST> httpse_urls_redirects_count_;
   HTTPSERecentlyUsedCache<std::string> recently_used_cache_;
-  leveldb::DB* level_db_;
+  // Guards replacing |rule_index_| against GetHTTPSURLFromCacheOnly, which
+  // reads the index from outside the task runner.
+  base::Lock rule_index_lock_;
+  std::unique_ptr<HTTPSEverywhereRuleIndex> rule_index_;
 
   SEQUENCE_CHECKER(sequence_checker_);
   DISALLOW_COPY_AND_ASSIGN(HTTPSEverywhereService);
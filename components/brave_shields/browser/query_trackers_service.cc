@@ -0,0 +1,201 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/query_trackers_service.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/strings/string_split.h"
+#include "base/strings/string_util.h"
+#include "base/synchronization/lock.h"
+#include "base/task_runner_util.h"
+#include "brave/components/brave_component_updater/browser/local_data_files_service.h"
+
+namespace brave_shields {
+
+namespace {
+
+const char kDatFileVersion[] = "1";
+const char kQueryTrackersFile[] = "QueryTrackers.dat";
+
+constexpr const char* kDefaultQueryTrackers[] = {
+    // https://github.com/brave/brave-browser/issues/4239
+    "fbclid", "gclid", "msclkid", "mc_eid",
+    // https://github.com/brave/brave-browser/issues/9879
+    "dclid",
+    // https://github.com/brave/brave-browser/issues/11579
+    "_openstat",
+    // https://github.com/brave/brave-browser/issues/11817
+    "vero_conv", "vero_id",
+    // https://github.com/brave/brave-browser/issues/11578
+    "yclid",
+    // https://github.com/brave/brave-browser/issues/9019
+    "_hsenc", "__hssc", "__hstc", "__hsfp", "hsCtaTracking"};
+
+struct CurrentQueryTrackers {
+  base::Lock lock;
+  scoped_refptr<const QueryTrackers> query_trackers;
+};
+
+base::LazyInstance<CurrentQueryTrackers>::Leaky g_current_query_trackers =
+    LAZY_INSTANCE_INITIALIZER;
+
+void SetCurrentQueryTrackers(
+    scoped_refptr<const QueryTrackers> query_trackers) {
+  CurrentQueryTrackers& current = g_current_query_trackers.Get();
+  base::AutoLock lock(current.lock);
+  current.query_trackers = std::move(query_trackers);
+}
+
+}  // namespace
+
+bool QueryTrackers::CaseInsensitiveCompare::operator()(
+    base::StringPiece lhs,
+    base::StringPiece rhs) const {
+  return base::CompareCaseInsensitiveASCII(lhs, rhs) < 0;
+}
+
+QueryTrackers::QueryTrackers(const std::vector<std::string>& names)
+    : names_(names.begin(), names.end()) {
+  for (const auto& name : names_) {
+    min_length_ = min_length_ ? std::min(min_length_, name.size())
+                              : name.size();
+    max_length_ = std::max(max_length_, name.size());
+  }
+}
+
+QueryTrackers::~QueryTrackers() = default;
+
+// static
+scoped_refptr<const QueryTrackers> QueryTrackers::CreateDefault() {
+  return base::MakeRefCounted<QueryTrackers>(std::vector<std::string>(
+      std::begin(kDefaultQueryTrackers), std::end(kDefaultQueryTrackers)));
+}
+
+bool QueryTrackers::Contains(base::StringPiece name) const {
+  // Most parameter names can be ruled out without a lookup.
+  if (name.size() < min_length_ || name.size() > max_length_)
+    return false;
+  return names_.find(name) != names_.end();
+}
+
+bool QueryTrackers::IsTrackerParameter(base::StringPiece parameter) const {
+  const size_t separator = parameter.find('=');
+  if (separator == base::StringPiece::npos ||
+      separator + 1 == parameter.size()) {
+    return false;
+  }
+  return Contains(parameter.substr(0, separator));
+}
+
+bool QueryTrackers::StripQuery(base::StringPiece query,
+                               std::string* stripped_query) const {
+  DCHECK(stripped_query);
+
+  // Find the first tracker before allocating anything, as most queries have
+  // none.
+  size_t start = 0;
+  for (;;) {
+    const size_t end = std::min(query.find('&', start), query.size());
+    if (IsTrackerParameter(query.substr(start, end - start)))
+      break;
+    if (end == query.size())
+      return false;
+    start = end + 1;
+  }
+
+  // Keep every other parameter, joined as they were.
+  std::string result;
+  result.reserve(query.size());
+  query.substr(0, start ? start - 1 : 0).AppendToString(&result);
+  bool first = start == 0;
+  for (;;) {
+    const size_t end = std::min(query.find('&', start), query.size());
+    const base::StringPiece parameter = query.substr(start, end - start);
+    if (!IsTrackerParameter(parameter)) {
+      if (!first)
+        result.push_back('&');
+      parameter.AppendToString(&result);
+      first = false;
+    }
+    if (end == query.size())
+      break;
+    start = end + 1;
+  }
+
+  *stripped_query = std::move(result);
+  return true;
+}
+
+QueryTrackersService::QueryTrackersService(
+    LocalDataFilesService* local_data_files_service)
+    : LocalDataFilesObserver(local_data_files_service) {}
+
+QueryTrackersService::~QueryTrackersService() {}
+
+// static
+scoped_refptr<const QueryTrackers> QueryTrackersService::GetQueryTrackers() {
+  CurrentQueryTrackers& current = g_current_query_trackers.Get();
+  base::AutoLock lock(current.lock);
+  if (!current.query_trackers)
+    current.query_trackers = QueryTrackers::CreateDefault();
+  return current.query_trackers;
+}
+
+// static
+void QueryTrackersService::SetQueryTrackersForTesting(
+    scoped_refptr<const QueryTrackers> query_trackers) {
+  SetCurrentQueryTrackers(std::move(query_trackers));
+}
+
+void QueryTrackersService::OnComponentReady(
+    const std::string& component_id,
+    const base::FilePath& install_dir,
+    const std::string& manifest) {
+  base::FilePath query_trackers_path = install_dir
+      .AppendASCII(kDatFileVersion)
+      .AppendASCII(kQueryTrackersFile);
+
+  base::PostTaskAndReplyWithResult(
+      local_data_files_service()->GetTaskRunner().get(),
+      FROM_HERE,
+      base::BindOnce(&brave_component_updater::GetDATFileAsString,
+                     query_trackers_path),
+      base::BindOnce(&QueryTrackersService::OnGetDATFileData,
+                     weak_factory_.GetWeakPtr()));
+}
+
+void QueryTrackersService::OnGetDATFileData(std::string contents) {
+  if (contents.empty()) {
+    // Older components don't ship the list, so keep the built-in one.
+    VLOG(1) << "Could not obtain query string trackers data";
+    return;
+  }
+
+  std::vector<std::string> query_trackers =
+      base::SplitString(base::StringPiece(contents.data(), contents.size()),
+                        ",", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+
+  if (query_trackers.empty()) {
+    LOG(ERROR) << "No query string trackers found";
+    return;
+  }
+
+  SetCurrentQueryTrackers(
+      base::MakeRefCounted<QueryTrackers>(query_trackers));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+std::unique_ptr<QueryTrackersService> QueryTrackersServiceFactory(
+    LocalDataFilesService* local_data_files_service) {
+  return std::make_unique<QueryTrackersService>(local_data_files_service);
+}
+
+}  // namespace brave_shields
@@ -0,0 +1,90 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_QUERY_TRACKERS_SERVICE_H_
+#define BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_QUERY_TRACKERS_SERVICE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/containers/flat_set.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "base/strings/string_piece.h"
+#include "brave/components/brave_component_updater/browser/local_data_files_observer.h"
+
+using brave_component_updater::LocalDataFilesObserver;
+using brave_component_updater::LocalDataFilesService;
+
+namespace brave_shields {
+
+// The names of query string parameters used for tracking, compared
+// case-insensitively. Immutable, so that it can be shared between threads.
+class QueryTrackers : public base::RefCountedThreadSafe<QueryTrackers> {
+ public:
+  explicit QueryTrackers(const std::vector<std::string>& names);
+
+  // Returns the parameters built into the browser.
+  static scoped_refptr<const QueryTrackers> CreateDefault();
+
+  bool Contains(base::StringPiece name) const;
+
+  // Removes the tracker parameters with a value from |query| in a single
+  // pass. Returns false, leaving |stripped_query| untouched, if there are
+  // none.
+  bool StripQuery(base::StringPiece query, std::string* stripped_query) const;
+
+ private:
+  friend class base::RefCountedThreadSafe<QueryTrackers>;
+  ~QueryTrackers();
+
+  // Returns true for "<tracker>=<value>" with a non-empty value.
+  bool IsTrackerParameter(base::StringPiece parameter) const;
+
+  struct CaseInsensitiveCompare {
+    using is_transparent = void;
+    bool operator()(base::StringPiece lhs, base::StringPiece rhs) const;
+  };
+
+  base::flat_set<std::string, CaseInsensitiveCompare> names_;
+  size_t min_length_ = 0;
+  size_t max_length_ = 0;
+
+  DISALLOW_COPY_AND_ASSIGN(QueryTrackers);
+};
+
+// Keeps the query string trackers up to date with the local data files
+// component, which can ship a newer list than the one built into the browser.
+class QueryTrackersService : public LocalDataFilesObserver {
+ public:
+  explicit QueryTrackersService(
+      LocalDataFilesService* local_data_files_service);
+  ~QueryTrackersService() override;
+
+  // Returns the current trackers. Can be called from any thread.
+  static scoped_refptr<const QueryTrackers> GetQueryTrackers();
+  static void SetQueryTrackersForTesting(
+      scoped_refptr<const QueryTrackers> query_trackers);
+
+  // implementation of LocalDataFilesObserver
+  void OnComponentReady(const std::string& component_id,
+                        const base::FilePath& install_dir,
+                        const std::string& manifest) override;
+
+ private:
+  void OnGetDATFileData(std::string contents);
+
+  base::WeakPtrFactory<QueryTrackersService> weak_factory_{this};
+  DISALLOW_COPY_AND_ASSIGN(QueryTrackersService);
+};
+
+// Creates the QueryTrackersService
+std::unique_ptr<QueryTrackersService> QueryTrackersServiceFactory(
+    LocalDataFilesService* local_data_files_service);
+
+}  // namespace brave_shields
+
+#endif  // BRAVE_COMPONENTS_BRAVE_SHIELDS_BROWSER_QUERY_TRACKERS_SERVICE_H_
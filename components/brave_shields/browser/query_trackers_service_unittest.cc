@@ -0,0 +1,199 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/brave_shields/browser/query_trackers_service.h"
+
+#include <string>
+#include <vector>
+
+#include "base/logging.h"
+#include "base/stl_util.h"
+#include "base/strings/string_util.h"
+#include "base/timer/elapsed_timer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/re2/src/re2/re2.h"
+
+namespace brave_shields {
+
+namespace {
+
+const char* const kTrackers[] = {"fbclid", "gclid", "msclkid", "mc_eid",
+                                 "dclid", "_openstat", "vero_conv", "vero_id",
+                                 "yclid", "_hsenc", "__hssc", "__hstc",
+                                 "__hsfp", "hsCtaTracking"};
+
+const char* const kQueryParts[] = {
+    "fbclid", "FBCLID", "gclid", "hsctatracking", "fbclidx", "xfbclid", "foo",
+    "bar", "=", "==", "&", "&&", "1", "abc", "%26", "?", "#", ""};
+
+// The regular expressions previously used to strip the trackers
+class RegularExpressionStripper {
+ public:
+  RegularExpressionStripper()
+      : tracker_appended_matcher_("&(" + GetTrackers() + ")=[^&]+",
+                                  GetOptions()),
+        tracker_first_matcher_("^(" + GetTrackers() + ")=[^&]+&",
+                               GetOptions()),
+        tracker_only_matcher_("^(" + GetTrackers() + ")=[^&]+$",
+                              GetOptions()) {}
+
+  bool StripQuery(const std::string& query,
+                  std::string* stripped_query) const {
+    std::string new_query = query;
+    // Note: the ordering of these replacements is important.
+    const int replacement_count =
+        re2::RE2::GlobalReplace(&new_query, tracker_appended_matcher_, "") +
+        re2::RE2::GlobalReplace(&new_query, tracker_first_matcher_, "") +
+        re2::RE2::GlobalReplace(&new_query, tracker_only_matcher_, "");
+    if (replacement_count == 0)
+      return false;
+    *stripped_query = new_query;
+    return true;
+  }
+
+ private:
+  static std::string GetTrackers() {
+    return base::JoinString(
+        std::vector<std::string>(std::begin(kTrackers), std::end(kTrackers)),
+        "|");
+  }
+
+  static re2::RE2::Options GetOptions() {
+    re2::RE2::Options options;
+    options.set_case_sensitive(false);
+    return options;
+  }
+
+  const re2::RE2 tracker_appended_matcher_;
+  const re2::RE2 tracker_first_matcher_;
+  const re2::RE2 tracker_only_matcher_;
+};
+
+scoped_refptr<const QueryTrackers> CreateQueryTrackers() {
+  return base::MakeRefCounted<QueryTrackers>(
+      std::vector<std::string>(std::begin(kTrackers), std::end(kTrackers)));
+}
+
+}  // namespace
+
+TEST(QueryTrackersTest, StripQuery) {
+  auto query_trackers = CreateQueryTrackers();
+  const struct {
+    const char* query;
+    const char* stripped_query;
+  } kCases[] = {
+      {"fbclid=1", ""},
+      {"fbclid=1&foo=1", "foo=1"},
+      {"foo=1&fbclid=1", "foo=1"},
+      {"foo=1&fbclid=1&bar=2", "foo=1&bar=2"},
+      {"FbClId=1&gclid=2&foo=1&hsctatracking=3", "foo=1"},
+      {"&fbclid=1", ""},
+      {"fbclid=1&", ""},
+      {"&&fbclid=1", "&"},
+      {"fbclid=1&&gclid=2", ""},
+      {"fbclid==1", ""},
+  };
+  for (const auto& c : kCases) {
+    std::string stripped_query = "untouched";
+    EXPECT_TRUE(query_trackers->StripQuery(c.query, &stripped_query))
+        << c.query;
+    EXPECT_EQ(c.stripped_query, stripped_query) << c.query;
+  }
+}
+
+TEST(QueryTrackersTest, StripQueryWithoutTrackers) {
+  auto query_trackers = CreateQueryTrackers();
+  for (const char* query :
+       {"", "foo=1", "fbclid", "fbclid=", "fbclid=&foo=1", "fbclidx=1",
+        "foo=fbclid=1", "foo=1&fbclid"}) {
+    std::string stripped_query = "untouched";
+    EXPECT_FALSE(query_trackers->StripQuery(query, &stripped_query)) << query;
+    EXPECT_EQ("untouched", stripped_query) << query;
+  }
+}
+
+TEST(QueryTrackersTest, DefaultTrackers) {
+  auto query_trackers = QueryTrackers::CreateDefault();
+  for (const char* tracker : kTrackers)
+    EXPECT_TRUE(query_trackers->Contains(tracker)) << tracker;
+  EXPECT_TRUE(query_trackers->Contains("HSCTATRACKING"));
+  EXPECT_FALSE(query_trackers->Contains("utm_source"));
+  EXPECT_FALSE(query_trackers->Contains(""));
+}
+
+TEST(QueryTrackersTest, StripQueryLikeRegularExpressions) {
+  auto query_trackers = CreateQueryTrackers();
+  const RegularExpressionStripper regular_expression_stripper;
+
+  // Deterministic so that any failure can be reproduced.
+  uint32_t state = 0x9e3779b9;
+  auto next = [&state]() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  };
+
+  for (size_t i = 0; i < 20000; ++i) {
+    std::string query;
+    const size_t part_count = next() % 12;
+    for (size_t j = 0; j < part_count; ++j)
+      query += kQueryParts[next() % base::size(kQueryParts)];
+
+    std::string expected_stripped_query;
+    const bool expected_stripped = regular_expression_stripper.StripQuery(
+        query, &expected_stripped_query);
+    std::string stripped_query;
+    ASSERT_EQ(expected_stripped,
+              query_trackers->StripQuery(query, &stripped_query))
+        << query;
+    if (expected_stripped)
+      ASSERT_EQ(expected_stripped_query, stripped_query) << query;
+  }
+}
+
+// Disabled by default, as it is a benchmark. Run it with
+// --gtest_also_run_disabled_tests.
+TEST(QueryTrackersTest, DISABLED_StripQueryBenchmark) {
+  auto query_trackers = CreateQueryTrackers();
+  const RegularExpressionStripper regular_expression_stripper;
+  const std::vector<std::string> queries = {
+      "",
+      "q=brave+browser&hl=en",
+      "utm_source=newsletter&utm_medium=email&utm_campaign=launch",
+      "fbclid=IwAR0abcdefghijklmnopqrstuvwxyz",
+      "id=42&gclid=Cj0KCQjw&ref=home&_hsenc=p2ANqtz&__hstc=1234&page=2",
+  };
+  const size_t kIterations = 20000;
+
+  base::ElapsedTimer regex_timer;
+  size_t regex_stripped_count = 0;
+  std::string stripped_query;
+  for (size_t i = 0; i < kIterations; ++i) {
+    if (regular_expression_stripper.StripQuery(queries[i % queries.size()],
+                                               &stripped_query)) {
+      regex_stripped_count++;
+    }
+  }
+  const base::TimeDelta regex_elapsed = regex_timer.Elapsed();
+
+  base::ElapsedTimer timer;
+  size_t stripped_count = 0;
+  for (size_t i = 0; i < kIterations; ++i) {
+    if (query_trackers->StripQuery(queries[i % queries.size()],
+                                   &stripped_query)) {
+      stripped_count++;
+    }
+  }
+  const base::TimeDelta elapsed = timer.Elapsed();
+
+  EXPECT_EQ(regex_stripped_count, stripped_count);
+  LOG(INFO) << "Stripped " << kIterations << " queries in "
+            << elapsed.InMicroseconds() << "us ("
+            << regex_elapsed.InMicroseconds()
+            << "us using regular expressions)";
+}
+
+}  // namespace brave_shields
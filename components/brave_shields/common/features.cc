@@ -14,5 +14,29 @@ const base::Feature kBraveAdblockCosmeticFiltering{
     "BraveAdblockCosmeticFiltering",
     base::FEATURE_ENABLED_BY_DEFAULT};
 
+// Caches CNAME resolutions per profile and matches requests to unknown hosts
+// before, rather than after, resolving them.
+const base::Feature kBraveAdblockCnameCache{
+    "BraveAdblockCnameCache",
+    base::FEATURE_ENABLED_BY_DEFAULT};
+
+// Matches network requests against published engine snapshots on the thread
+// pool instead of serially on the ad-block task runner.
+const base::Feature kBraveAdblockParallelMatching{
+    "BraveAdblockParallelMatching",
+    base::FEATURE_DISABLED_BY_DEFAULT};
+
+// Shares one snapshot of the shields settings between the requests of a
+// top-frame origin instead of looking them up for every request.
+const base::Feature kBraveShieldsSettingsCache{
+    "BraveShieldsSettingsCache",
+    base::FEATURE_ENABLED_BY_DEFAULT};
+
+// Runs the network request callbacks of BraveRequestHandler on a sequence of
+// the thread pool, only going to the UI thread for what has to run there.
+const base::Feature kBraveRequestHandlerSequence{
+    "BraveRequestHandlerSequence",
+    base::FEATURE_DISABLED_BY_DEFAULT};
+
 }  // namespace features
 }  // namespace brave_shields
@@ -13,6 +13,10 @@ struct Feature;
 namespace brave_shields {
 namespace features {
 extern const base::Feature kBraveAdblockCosmeticFiltering;
+extern const base::Feature kBraveAdblockCnameCache;
+extern const base::Feature kBraveAdblockParallelMatching;
+extern const base::Feature kBraveShieldsSettingsCache;
+extern const base::Feature kBraveRequestHandlerSequence;
 }  // namespace features
 }  // namespace brave_shields
 
@@ -10,8 +10,10 @@
 #include <utility>
 #include <vector>
 
+#include "base/containers/span.h"
 #include "base/logging.h"
 #include "brave/base/containers/utils.h"
+#include "mojo/public/cpp/base/big_buffer.h"
 
 namespace bat_ledger {
 
@@ -386,4 +388,40 @@ std::string BatLedgerClientMojoBridge::GetEncryptedStringState(
   return value;
 }
 
+void OnSavePublisherPrefixList(
+    const ledger::client::ResultCallback callback,
+    const ledger::type::Result result) {
+  callback(result);
+}
+
+void BatLedgerClientMojoBridge::SavePublisherPrefixList(
+    const std::string& prefixes,
+    ledger::client::ResultCallback callback) {
+  if (!Connected()) {
+    callback(ledger::type::Result::LEDGER_ERROR);
+    return;
+  }
+
+  bat_ledger_client_->SavePublisherPrefixList(
+      mojo_base::BigBuffer(base::as_bytes(base::make_span(prefixes))),
+      base::BindOnce(&OnSavePublisherPrefixList, std::move(callback)));
+}
+
+void OnLoadPublisherPrefixList(
+    const ledger::client::LoadPublisherPrefixListCallback callback,
+    base::File file) {
+  callback(std::move(file));
+}
+
+void BatLedgerClientMojoBridge::LoadPublisherPrefixList(
+    ledger::client::LoadPublisherPrefixListCallback callback) {
+  if (!Connected()) {
+    callback(base::File());
+    return;
+  }
+
+  bat_ledger_client_->LoadPublisherPrefixList(
+      base::BindOnce(&OnLoadPublisherPrefixList, std::move(callback)));
+}
+
 }  // namespace bat_ledger
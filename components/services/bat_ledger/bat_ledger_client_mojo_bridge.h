@@ -124,6 +124,13 @@ class BatLedgerClientMojoBridge :
 
   std::string GetEncryptedStringState(const std::string& name) override;
 
+  void SavePublisherPrefixList(
+      const std::string& prefixes,
+      ledger::client::ResultCallback callback) override;
+
+  void LoadPublisherPrefixList(
+      ledger::client::LoadPublisherPrefixListCallback callback) override;
+
  private:
   bool Connected() const;
 
@@ -7,6 +7,7 @@
 
 #include "base/logging.h"
 #include "brave/base/containers/utils.h"
+#include "mojo/public/cpp/base/big_buffer.h"
 
 using std::placeholders::_1;
 using std::placeholders::_2;
@@ -390,4 +391,51 @@ void LedgerClientMojoBridge::GetEncryptedStringState(
   std::move(callback).Run(ledger_client_->GetEncryptedStringState(name));
 }
 
+// static
+void LedgerClientMojoBridge::OnSavePublisherPrefixList(
+    CallbackHolder<SavePublisherPrefixListCallback>* holder,
+    const ledger::type::Result result) {
+  DCHECK(holder);
+  if (holder->is_valid()) {
+    std::move(holder->get()).Run(result);
+  }
+  delete holder;
+}
+
+void LedgerClientMojoBridge::SavePublisherPrefixList(
+    mojo_base::BigBuffer prefixes,
+    SavePublisherPrefixListCallback callback) {
+  auto* holder = new CallbackHolder<SavePublisherPrefixListCallback>(
+      AsWeakPtr(),
+      std::move(callback));
+  ledger_client_->SavePublisherPrefixList(
+      std::string(reinterpret_cast<const char*>(prefixes.data()),
+          prefixes.size()),
+      std::bind(LedgerClientMojoBridge::OnSavePublisherPrefixList,
+                holder,
+                _1));
+}
+
+// static
+void LedgerClientMojoBridge::OnLoadPublisherPrefixList(
+    CallbackHolder<LoadPublisherPrefixListCallback>* holder,
+    base::File file) {
+  DCHECK(holder);
+  if (holder->is_valid()) {
+    std::move(holder->get()).Run(std::move(file));
+  }
+  delete holder;
+}
+
+void LedgerClientMojoBridge::LoadPublisherPrefixList(
+    LoadPublisherPrefixListCallback callback) {
+  auto* holder = new CallbackHolder<LoadPublisherPrefixListCallback>(
+      AsWeakPtr(),
+      std::move(callback));
+  ledger_client_->LoadPublisherPrefixList(
+      std::bind(LedgerClientMojoBridge::OnLoadPublisherPrefixList,
+                holder,
+                _1));
+}
+
 }  // namespace bat_ledger
@@ -142,6 +142,13 @@ class LedgerClientMojoBridge :
       const std::string& name,
       GetEncryptedStringStateCallback callback) override;
 
+  void SavePublisherPrefixList(
+      mojo_base::BigBuffer prefixes,
+      SavePublisherPrefixListCallback callback) override;
+
+  void LoadPublisherPrefixList(
+      LoadPublisherPrefixListCallback callback) override;
+
  private:
   // workaround to pass base::OnceCallback into std::bind
   template <typename Callback>
@@ -196,6 +203,14 @@ class LedgerClientMojoBridge :
       CallbackHolder<DeleteLogCallback>* holder,
       const ledger::type::Result result);
 
+  static void OnSavePublisherPrefixList(
+      CallbackHolder<SavePublisherPrefixListCallback>* holder,
+      const ledger::type::Result result);
+
+  static void OnLoadPublisherPrefixList(
+      CallbackHolder<LoadPublisherPrefixListCallback>* holder,
+      base::File file);
+
   ledger::LedgerClient* ledger_client_;
 };
 
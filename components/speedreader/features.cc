@@ -19,4 +19,9 @@ const base::Feature kSpeedreaderFeature {
 #endif
 };
 
+// Rewrites the response body as it streams in and starts sending distilled
+// output before the whole page has been downloaded.
+const base::Feature kSpeedreaderStreamingFeature{
+    "SpeedreaderStreaming", base::FEATURE_DISABLED_BY_DEFAULT};
+
 }  // namespace speedreader
@@ -92,6 +92,14 @@ std::unique_ptr<Rewriter> SpeedreaderRewriterService::MakeRewriter(
   return speedreader_->MakeRewriter(url.spec());
 }
 
+std::unique_ptr<Rewriter> SpeedreaderRewriterService::MakeRewriter(
+    const GURL& url,
+    void (*output_sink)(const char*, size_t, void*),
+    void* output_sink_user_data) {
+  return speedreader_->MakeRewriter(url.spec(), RewriterType::RewriterUnknown,
+                                    output_sink, output_sink_user_data);
+}
+
 const std::string& SpeedreaderRewriterService::GetContentStylesheet() {
   return content_stylesheet_;
 }
@@ -102,10 +110,10 @@ void SpeedreaderRewriterService::OnLoadStylesheet(std::string stylesheet) {
 }
 
 void SpeedreaderRewriterService::OnLoadDATFileData(
-    GetDATFileDataResult result) {
+    std::unique_ptr<speedreader::SpeedReader> speedreader) {
   VLOG(2) << "Speedreader loaded from DAT file";
-  if (result.first)
-    speedreader_ = std::move(result.first);
+  if (speedreader)
+    speedreader_ = std::move(speedreader);
 }
 
 }  // namespace speedreader
@@ -44,13 +44,16 @@ class SpeedreaderRewriterService : public SpeedreaderComponent::Observer {
   // The API
   bool IsWhitelisted(const GURL& url);
   std::unique_ptr<Rewriter> MakeRewriter(const GURL& url);
+  // Creates a rewriter that hands every chunk of output to |output_sink| as
+  // soon as it is produced instead of accumulating it.
+  std::unique_ptr<Rewriter> MakeRewriter(
+      const GURL& url,
+      void (*output_sink)(const char*, size_t, void*),
+      void* output_sink_user_data);
   const std::string& GetContentStylesheet();
 
  private:
-  using GetDATFileDataResult =
-      brave_component_updater::LoadDATFileDataResult<speedreader::SpeedReader>;
-
-  void OnLoadDATFileData(GetDATFileDataResult result);
+  void OnLoadDATFileData(std::unique_ptr<speedreader::SpeedReader> speedreader);
   void OnLoadStylesheet(std::string stylesheet);
 
   std::string content_stylesheet_;
@@ -0,0 +1,62 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#include "brave/components/speedreader/speedreader_streaming_rewriter.h"
+
+#include <utility>
+
+#include "base/bind.h"
+#include "base/sequenced_task_runner.h"
+#include "base/threading/sequenced_task_runner_handle.h"
+#include "brave/components/speedreader/rust/ffi/speedreader.h"
+#include "brave/components/speedreader/speedreader_rewriter_service.h"
+#include "url/gurl.h"
+
+namespace speedreader {
+
+SpeedreaderStreamingRewriter::SpeedreaderStreamingRewriter(
+    SpeedreaderRewriterService* rewriter_service,
+    const GURL& url,
+    OutputCallback output_callback)
+    : reply_task_runner_(base::SequencedTaskRunnerHandle::Get()),
+      output_callback_(std::move(output_callback)),
+      rewriter_(rewriter_service->MakeRewriter(
+          url,
+          &SpeedreaderStreamingRewriter::OnOutput,
+          this)) {
+  // Everything else happens on the background sequence.
+  DETACH_FROM_SEQUENCE(sequence_checker_);
+}
+
+SpeedreaderStreamingRewriter::~SpeedreaderStreamingRewriter() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+}
+
+void SpeedreaderStreamingRewriter::Write(std::string chunk) {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  if (failed_)
+    return;
+  failed_ = rewriter_->Write(chunk.data(), chunk.size()) != 0;
+}
+
+bool SpeedreaderStreamingRewriter::End() {
+  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+  if (failed_)
+    return false;
+  failed_ = rewriter_->End() != 0;
+  return !failed_;
+}
+
+// static
+void SpeedreaderStreamingRewriter::OnOutput(const char* chunk,
+                                            size_t chunk_len,
+                                            void* user_data) {
+  auto* self = static_cast<SpeedreaderStreamingRewriter*>(user_data);
+  self->reply_task_runner_->PostTask(
+      FROM_HERE, base::BindOnce(self->output_callback_,
+                                std::string(chunk, chunk_len)));
+}
+
+}  // namespace speedreader
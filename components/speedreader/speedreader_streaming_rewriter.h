@@ -0,0 +1,64 @@
+/* Copyright (c) 2020 The Brave Authors. All rights reserved.
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/. */
+
+#ifndef BRAVE_COMPONENTS_SPEEDREADER_SPEEDREADER_STREAMING_REWRITER_H_
+#define BRAVE_COMPONENTS_SPEEDREADER_SPEEDREADER_STREAMING_REWRITER_H_
+
+#include <memory>
+#include <string>
+
+#include "base/callback.h"
+#include "base/memory/scoped_refptr.h"
+#include "base/sequence_checker.h"
+
+namespace base {
+class SequencedTaskRunner;
+}  // namespace base
+
+class GURL;
+
+namespace speedreader {
+
+class Rewriter;
+class SpeedreaderRewriterService;
+
+// Feeds a response body into a Speedreader |Rewriter| chunk by chunk as it
+// arrives, relaying every chunk of output the rewriter produces back to the
+// sequence that created it.
+//
+// Created on the loader's sequence, then used and destroyed exclusively on a
+// background sequence, so that the rewriting work never blocks the loader.
+class SpeedreaderStreamingRewriter {
+ public:
+  using OutputCallback = base::RepeatingCallback<void(std::string)>;
+
+  SpeedreaderStreamingRewriter(SpeedreaderRewriterService* rewriter_service,
+                               const GURL& url,
+                               OutputCallback output_callback);
+  ~SpeedreaderStreamingRewriter();
+
+  SpeedreaderStreamingRewriter(const SpeedreaderStreamingRewriter&) = delete;
+  SpeedreaderStreamingRewriter& operator=(
+      const SpeedreaderStreamingRewriter&) = delete;
+
+  // Must be called on the background sequence.
+  void Write(std::string chunk);
+  // Flushes the rewriter. Returns false if rewriting failed at any point.
+  bool End();
+
+ private:
+  static void OnOutput(const char* chunk, size_t chunk_len, void* user_data);
+
+  scoped_refptr<base::SequencedTaskRunner> reply_task_runner_;
+  OutputCallback output_callback_;
+  std::unique_ptr<Rewriter> rewriter_;
+  bool failed_ = false;
+
+  SEQUENCE_CHECKER(sequence_checker_);
+};
+
+}  // namespace speedreader
+
+#endif  // BRAVE_COMPONENTS_SPEEDREADER_SPEEDREADER_STREAMING_REWRITER_H_
@@ -5,15 +5,20 @@
 
 #include "brave/components/speedreader/speedreader_url_loader.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <utility>
 
 #include "base/bind.h"
 #include "base/metrics/histogram_macros.h"
+#include "base/feature_list.h"
 #include "base/task/post_task.h"
+#include "base/task/thread_pool.h"
+#include "brave/components/speedreader/features.h"
 #include "brave/components/speedreader/rust/ffi/speedreader.h"
 #include "brave/components/speedreader/speedreader_rewriter_service.h"
+#include "brave/components/speedreader/speedreader_streaming_rewriter.h"
 #include "brave/components/speedreader/speedreader_throttle.h"
 #include "mojo/public/cpp/bindings/self_owned_receiver.h"
 #include "services/network/public/mojom/url_response_head.mojom.h"
@@ -24,6 +29,10 @@ namespace {
 
 constexpr uint32_t kReadBufferSize = 32768;
 
+// TODO(brave-browser/issues/10372): would be better to pass explicit signal
+// back from rewriter to indicate if content was found
+constexpr size_t kMinDistilledSize = 1024;
+
 }  // namespace
 
 // static
@@ -68,7 +77,8 @@ SpeedReaderURLLoader::SpeedReaderURLLoader(
       body_producer_watcher_(FROM_HERE,
                              mojo::SimpleWatcher::ArmingPolicy::MANUAL,
                              std::move(task_runner)),
-      rewriter_service_(rewriter_service) {}
+      rewriter_service_(rewriter_service),
+      streaming_rewriter_(nullptr, base::OnTaskRunnerDeleter(nullptr)) {}
 
 SpeedReaderURLLoader::~SpeedReaderURLLoader() = default;
 
@@ -119,6 +129,22 @@ void SpeedReaderURLLoader::OnStartLoadingResponseBody(
   VLOG(2) << __func__ << " " << response_url_;
   state_ = State::kLoading;
   body_consumer_handle_ = std::move(body);
+  body_start_time_ = base::TimeTicks::Now();
+
+  if (base::FeatureList::IsEnabled(kSpeedreaderStreamingFeature) &&
+      rewriter_service_) {
+    rewriter_task_runner_ = base::ThreadPool::CreateSequencedTaskRunner(
+        {base::TaskPriority::USER_BLOCKING});
+    streaming_rewriter_ =
+        std::unique_ptr<SpeedreaderStreamingRewriter,
+                        base::OnTaskRunnerDeleter>(
+            new SpeedreaderStreamingRewriter(
+                rewriter_service_, response_url_,
+                base::BindRepeating(&SpeedReaderURLLoader::OnRewriterOutput,
+                                    weak_factory_.GetWeakPtr())),
+            base::OnTaskRunnerDeleter(rewriter_task_runner_));
+  }
+
   body_consumer_watcher_.Watch(
       body_consumer_handle_.get(),
       MOJO_HANDLE_SIGNAL_READABLE | MOJO_HANDLE_SIGNAL_PEER_CLOSED,
@@ -188,6 +214,10 @@ void SpeedReaderURLLoader::ResumeReadingBodyFromNet() {
 }
 
 void SpeedReaderURLLoader::OnBodyReadable(MojoResult) {
+  if (streaming_rewriter_) {
+    OnBodyReadableForStreaming();
+    return;
+  }
   DCHECK_EQ(State::kLoading, state_);
 
   size_t start_size = buffered_body_.size();
@@ -213,18 +243,134 @@ void SpeedReaderURLLoader::OnBodyReadable(MojoResult) {
 
   DCHECK_EQ(MOJO_RESULT_OK, result);
   buffered_body_.resize(start_size + read_bytes);
-  // TODO(iefremov): We actually can partially |pumpContent| to speedreader,
-  // but skipping it for now to simplify things. Pumping is not free in terms
-  // of CPU ticks, so we will have to keep alive speedreader instance on another
-  // thread.
+  UpdatePeakBufferedBytes();
 
   body_consumer_watcher_.ArmOrNotify();
 }
 
+void SpeedReaderURLLoader::OnBodyReadableForStreaming() {
+  // Reading continues after the loader committed to the distilled body and
+  // started sending it.
+  DCHECK(state_ == State::kLoading || state_ == State::kSending);
+
+  std::string chunk(kReadBufferSize, '\0');
+  uint32_t read_bytes = kReadBufferSize;
+  MojoResult result = body_consumer_handle_->ReadData(
+      &chunk[0], &read_bytes, MOJO_READ_DATA_FLAG_NONE);
+  switch (result) {
+    case MOJO_RESULT_OK:
+      break;
+    case MOJO_RESULT_FAILED_PRECONDITION:
+      // Reading is finished.
+      body_consumer_watcher_.Cancel();
+      base::PostTaskAndReplyWithResult(
+          rewriter_task_runner_.get(), FROM_HERE,
+          base::BindOnce(&SpeedreaderStreamingRewriter::End,
+                         base::Unretained(streaming_rewriter_.get())),
+          base::BindOnce(&SpeedReaderURLLoader::OnStreamingRewriterEnd,
+                         weak_factory_.GetWeakPtr()));
+      return;
+    case MOJO_RESULT_SHOULD_WAIT:
+      body_consumer_watcher_.ArmOrNotify();
+      return;
+    default:
+      NOTREACHED();
+      return;
+  }
+
+  DCHECK_EQ(MOJO_RESULT_OK, result);
+  chunk.resize(read_bytes);
+  // Keep the original until committing to the distilled version, so that it
+  // can still be sent if distilling fails.
+  if (!committed_) {
+    buffered_body_.append(chunk);
+    UpdatePeakBufferedBytes();
+  }
+  // |streaming_rewriter_| is deleted on |rewriter_task_runner_|, after any
+  // task posted here.
+  rewriter_task_runner_->PostTask(
+      FROM_HERE, base::BindOnce(&SpeedreaderStreamingRewriter::Write,
+                                base::Unretained(streaming_rewriter_.get()),
+                                std::move(chunk)));
+
+  body_consumer_watcher_.ArmOrNotify();
+}
+
+void SpeedReaderURLLoader::OnRewriterOutput(std::string chunk) {
+  if (state_ == State::kAborted || state_ == State::kCompleted)
+    return;
+
+  if (!committed_) {
+    DCHECK_EQ(State::kLoading, state_);
+    distilled_body_.append(chunk);
+    UpdatePeakBufferedBytes();
+    if (distilled_body_.size() < kMinDistilledSize)
+      return;
+
+    // Enough content has been found: drop the original and start sending.
+    committed_ = true;
+    buffered_body_.clear();
+    buffered_body_.shrink_to_fit();
+    std::string body =
+        rewriter_service_->GetContentStylesheet() + distilled_body_;
+    distilled_body_.clear();
+    distilled_body_.shrink_to_fit();
+    CompleteLoading(std::move(body));
+    return;
+  }
+
+  DCHECK_EQ(State::kSending, state_);
+  buffered_body_.append(chunk);
+  bytes_remaining_in_buffer_ += chunk.size();
+  UpdatePeakBufferedBytes();
+  if (waiting_for_output_) {
+    waiting_for_output_ = false;
+    SendReceivedBodyToClient();
+  }
+}
+
+void SpeedReaderURLLoader::OnStreamingRewriterEnd(bool success) {
+  rewriter_finished_ = true;
+  streaming_rewriter_.reset();
+  if (state_ == State::kAborted || state_ == State::kCompleted)
+    return;
+
+  if (committed_) {
+    DCHECK_EQ(State::kSending, state_);
+    // Otherwise OnBodyWritable() completes once the rest has been sent.
+    if (waiting_for_output_)
+      CompleteSending();
+    return;
+  }
+
+  DCHECK_EQ(State::kLoading, state_);
+  if (!throttle_) {
+    Abort();
+    return;
+  }
+  if (success && distilled_body_.size() >= kMinDistilledSize) {
+    CompleteLoading(rewriter_service_->GetContentStylesheet() +
+                    distilled_body_);
+    return;
+  }
+  // Distilling failed or found too little content; send the original.
+  distilled_body_.clear();
+  CompleteLoading(std::move(buffered_body_));
+}
+
+void SpeedReaderURLLoader::UpdatePeakBufferedBytes() {
+  peak_buffered_bytes_ =
+      std::max(peak_buffered_bytes_,
+               buffered_body_.size() + distilled_body_.size());
+}
+
 void SpeedReaderURLLoader::OnBodyWritable(MojoResult r) {
   DCHECK_EQ(State::kSending, state_);
   if (bytes_remaining_in_buffer_ > 0) {
     SendReceivedBodyToClient();
+  } else if (committed_ && !rewriter_finished_) {
+    // The rewriter may still produce more output.
+    waiting_for_output_ = true;
   } else {
     CompleteSending();
   }
@@ -256,11 +402,7 @@ void SpeedReaderURLLoader::MaybeLaunchSpeedreader() {
 
               rewriter->End();
               const std::string& transformed = rewriter->GetOutput();
-
-              // TODO(brave-browser/issues/10372): would be better to pass
-              // explicit signal back from rewriter to indicate if content was
-              // found
-              if (transformed.length() < 1024) {
+              if (transformed.length() < kMinDistilledSize) {
                 return data;
               }
 
@@ -279,6 +421,8 @@ void SpeedReaderURLLoader::MaybeLaunchSpeedreader() {
 void SpeedReaderURLLoader::CompleteLoading(std::string body) {
   DCHECK_EQ(State::kLoading, state_);
   state_ = State::kSending;
+  UMA_HISTOGRAM_TIMES("Brave.Speedreader.TimeToFirstByte",
+                      base::TimeTicks::Now() - body_start_time_);
 
   if (!throttle_) {
     Abort();
@@ -319,6 +463,8 @@ void SpeedReaderURLLoader::CompleteLoading(std::string body) {
 void SpeedReaderURLLoader::CompleteSending() {
   DCHECK_EQ(State::kSending, state_);
   state_ = State::kCompleted;
+  UMA_HISTOGRAM_MEMORY_KB("Brave.Speedreader.PeakBufferedBody",
+                          peak_buffered_bytes_ / 1024);
   // Call client's OnComplete() if |this|'s OnComplete() has already been
   // called.
   if (complete_status_.has_value())
@@ -355,6 +501,9 @@ void SpeedReaderURLLoader::SendReceivedBodyToClient() {
       return;
   }
   bytes_remaining_in_buffer_ -= bytes_sent;
+  // Output that has been streamed out doesn't need to be kept.
+  if (committed_ && !bytes_remaining_in_buffer_)
+    buffered_body_.clear();
   body_producer_watcher_.ArmOrNotify();
 }
 
@@ -6,6 +6,7 @@
 #ifndef BRAVE_COMPONENTS_SPEEDREADER_SPEEDREADER_URL_LOADER_H_
 #define BRAVE_COMPONENTS_SPEEDREADER_SPEEDREADER_URL_LOADER_H_
 
+#include <memory>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -13,7 +14,9 @@
 #include "base/callback.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/weak_ptr.h"
+#include "base/sequenced_task_runner.h"
 #include "base/strings/string_piece.h"
+#include "base/time/time.h"
 #include "mojo/public/cpp/bindings/binding.h"
 #include "mojo/public/cpp/bindings/pending_receiver.h"
 #include "mojo/public/cpp/bindings/pending_remote.h"
@@ -28,6 +31,7 @@ namespace speedreader {
 
 class SpeedReaderThrottle;
 class SpeedreaderRewriterService;
+class SpeedreaderStreamingRewriter;
 
 // Loads the whole response body and tries to Speedreader-distill it.
 // Cargoculted from |`SniffingURLLoader|.
@@ -50,6 +54,13 @@ class SpeedreaderRewriterService;
 // kAborted: Unexpected behavior happens. Watchers, pipes and the binding from
 //           the source loader to |this| are stopped. All incoming messages from
 //           the destination (through network::mojom::URLLoader) are ignored in
+//
+// With |kSpeedreaderStreamingFeature| the body is fed to the rewriter chunk by
+// chunk while it is being received. The original body is only kept until the
+// rewriter has produced enough output to be confident the page is readable;
+// at that point the loader moves to kSending and streams distilled output to
+// the destination while still reading from the source. If the rewriter fails
+// or produces too little output, the buffered original body is sent instead.
 class SpeedReaderURLLoader : public network::mojom::URLLoaderClient,
                              public network::mojom::URLLoader {
  public:
@@ -121,6 +132,12 @@ class SpeedReaderURLLoader : public network::mojom::URLLoaderClient,
 
   void Abort();
 
+  // Streaming mode.
+  void OnBodyReadableForStreaming();
+  void OnRewriterOutput(std::string chunk);
+  void OnStreamingRewriterEnd(bool success);
+  void UpdatePeakBufferedBytes();
+
   base::WeakPtr<SpeedReaderThrottle> throttle_;
 
   mojo::Receiver<network::mojom::URLLoaderClient> source_url_client_receiver_{
@@ -150,6 +167,23 @@ class SpeedReaderURLLoader : public network::mojom::URLLoaderClient,
   // Not Owned
   SpeedreaderRewriterService* rewriter_service_;
 
+  // Streaming mode state. |streaming_rewriter_| lives on
+  // |rewriter_task_runner_|.
+  scoped_refptr<base::SequencedTaskRunner> rewriter_task_runner_;
+  std::unique_ptr<SpeedreaderStreamingRewriter, base::OnTaskRunnerDeleter>
+      streaming_rewriter_;
+  // Rewriter output received before committing to the distilled version.
+  std::string distilled_body_;
+  // True once distilled output is being sent to the destination.
+  bool committed_ = false;
+  bool rewriter_finished_ = false;
+  // True when everything received so far has been sent, but the rewriter may
+  // still produce more output.
+  bool waiting_for_output_ = false;
+
+  base::TimeTicks body_start_time_;
+  size_t peak_buffered_bytes_ = 0;
+
   base::WeakPtrFactory<SpeedReaderURLLoader> weak_factory_{this};
 };
 